@@ -96,6 +96,28 @@ function build_hdc ()
 	popd
 }
 
+# BENCHMARK=1 also builds the protocol microbenchmarks, private members are reached by -fno-access-control
+function build_hdc_benchmark ()
+{
+	pushd developtools_hdc
+
+	DEFINES="-DHDC_HOST -DHARMONY_PROJECT"
+	export LDFLAGS="-Wl,--copy-dt-needed-entries"
+	export CXXFLAGS="-std=c++17 -ggdb -O2 -fno-access-control"
+	SOURCES="$(find src/common/ src/host/ \( -name "*.cpp" -or -name "*.c" \) ! -name main.cpp)"
+
+	g++ ${DEFINES} ${CXXFLAGS} ${INCLUDES} -Isrc/common -Itest/benchmark/common/include ${SOURCES} \
+		test/benchmark/common/hdc_benchmark.cpp -lusb-1.0 -ldl -lpthread $STATICLIB -o hdc_benchmark
+
+	if [ -f hdc_benchmark ]; then
+		echo build benchmark success
+		cp hdc_benchmark $cwddir
+	else
+		echo build benchmark fail
+	fi
+	popd
+}
+
 pushd $ohos_hdc_build
 
 if [ "X$KEEP" == "X" ]; then
@@ -116,5 +138,6 @@ build_lz4
 build_libusb
 
 build_hdc
+[ "X$BENCHMARK" == "X" ] || build_hdc_benchmark
 
 popd
@@ -58,6 +58,20 @@ void AsyncCmd::DoRelease()
     }
 }
 
+void AsyncCmd::Pause()
+{
+    if (childShell != nullptr) {
+        childShell->PauseRead();
+    }
+}
+
+void AsyncCmd::Resume()
+{
+    if (childShell != nullptr) {
+        childShell->ResumeRead();
+    }
+}
+
 bool AsyncCmd::Initial(uv_loop_t *loopIn, const CmdResultCallback callback, uint32_t optionsIn)
 {
 #if defined _WIN32 || defined HDC_HOST
@@ -74,7 +88,19 @@ bool AsyncCmd::FinishShellProc(const void *context, const bool result, const str
 {
     WRITE_LOG(LOG_DEBUG, "FinishShellProc finish");
     AsyncCmd *thisClass = (AsyncCmd *)context;
-    thisClass->resultCallback(true, result, thisClass->cmdResult + exitMsg);
+    string &cmdResult = thisClass->cmdResult;
+    if (cmdResult.size() > ASYNCCMD_RESULT_MAX) {
+        thisClass->resultDropped += cmdResult.size() - ASYNCCMD_RESULT_MAX;
+        cmdResult.erase(0, cmdResult.size() - ASYNCCMD_RESULT_MAX);
+    }
+    if (thisClass->resultDropped > 0) {
+        // the caller gets the tail only, say so in the result itself
+        cmdResult.insert(0, Base::StringFormat("[output truncated, first %" PRIu64 " bytes dropped]\n",
+                                               thisClass->resultDropped));
+    }
+    thisClass->resultCallback(true, result, cmdResult + exitMsg);
+    string().swap(cmdResult);
+    thisClass->resultDropped = 0;
     --thisClass->refCount;
     return true;
 };
@@ -83,8 +109,18 @@ bool AsyncCmd::ChildReadCallback(const void *context, uint8_t *buf, const int si
 {
     AsyncCmd *thisClass = (AsyncCmd *)context;
     if (thisClass->options & OPTION_COMMAND_ONETIME) {
-        string s((char *)buf, size);
-        thisClass->cmdResult += s;
+        string &cmdResult = thisClass->cmdResult;
+        // trim in steps of ASYNCCMD_RESULT_MAX, each byte is moved at most once
+        if (cmdResult.size() + size > ASYNCCMD_RESULT_MAX * 2) {
+            if (thisClass->resultDropped == 0) {
+                WRITE_LOG(LOG_INFO, "AsyncCmd result over %zu bytes, keep the tail", ASYNCCMD_RESULT_MAX);
+            }
+            size_t keep = ASYNCCMD_RESULT_MAX > static_cast<size_t>(size) ? ASYNCCMD_RESULT_MAX - size : 0;
+            size_t drop = cmdResult.size() > keep ? cmdResult.size() - keep : 0;
+            thisClass->resultDropped += drop;
+            cmdResult.erase(0, drop);
+        }
+        cmdResult.append((char *)buf, size);
         return true;
     }
     string s((char *)buf, size);
@@ -142,9 +178,18 @@ bool AsyncCmd::ExecuteCommand(const string &command)
 {
     string cmd = command;
     Base::Trim(cmd, "\"");
+#ifdef HDC_HOST
     if ((fd = Popen(cmd, true, pid)) < 0) {
         return false;
     }
+#else
+    HdcShellPool::Worker worker;
+    if (!HdcShellPool::Get().Launch(false, cmd, worker)) {
+        return false;
+    }
+    fd = worker.fdIO;
+    pid = worker.pid;
+#endif
     childShell = new(std::nothrow) HdcFileDescriptor(loop, fd, this, ChildReadCallback, FinishShellProc);
     if (childShell == nullptr) {
         WRITE_LOG(LOG_FATAL, "ExecuteCommand new childShell failed");
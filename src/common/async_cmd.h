@@ -22,12 +22,15 @@ public:
     AsyncCmd();
     virtual ~AsyncCmd();
     enum AsyncCmdOption {
+        // result once at exit, only the last ASYNCCMD_RESULT_MAX bytes are kept behind a truncated marker
         OPTION_COMMAND_ONETIME = 1,
         USB_OPTION_RESERVE2 = 2,
         OPTION_READBACK_OUT = 4,  // deprecated, remove it later
         USB_OPTION_RESERVE8 = 8,
     };
     // 1)is finish 2)exitStatus 3)resultString(maybe empty)
+    // Without OPTION_COMMAND_ONETIME each chunk is passed on as it is read, a caller that can't keep up
+    // calls Pause and Resume later so the output stays in the pipe instead of memory.
     using CmdResultCallback = std::function<bool(bool, int64_t, const string)>;
     // deprecated, remove it later
     static uint32_t GetDefaultOption()
@@ -39,6 +42,8 @@ public:
     void DoRelease();  // Release process resources
     bool ExecuteCommand(const string &command);
     bool ReadyForRelease();
+    void Pause();
+    void Resume();
 
 private:
     static bool FinishShellProc(const void *context, const bool result, const string exitMsg);
@@ -53,6 +58,7 @@ private:
     CmdResultCallback resultCallback;
     uv_loop_t *loop = nullptr;
     string cmdResult;
+    uint64_t resultDropped = 0;  // head bytes of a one-time result that did not fit
 };
 }  // namespace Hdc
 #endif
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "async_log.h"
+#include <chrono>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace Hdc {
+HdcAsyncLog::HdcAsyncLog()
+{
+    running = false;
+    stopped = false;
+    stopping = false;
+    flushRequest = 0;
+    flushDone = 0;
+    fileLog = nullptr;
+    pathIsCache = false;
+    fileSize = 0;
+    writer = new WriterSync();
+#ifndef _WIN32
+    pthread_atfork(AtForkPrepare, AtForkParent, AtForkChild);
+#endif
+}
+
+HdcAsyncLog::~HdcAsyncLog()
+{
+    Stop();
+}
+
+HdcAsyncLog *HdcAsyncLog::Get()
+{
+    static HdcAsyncLog instance;
+    if (instance.stopped) {
+        return nullptr;
+    }
+    return &instance;
+}
+
+#ifndef _WIN32
+// hold both locks over fork, so the child never inherits one locked by a thread it doesn't have
+void HdcAsyncLog::AtForkPrepare()
+{
+    HdcAsyncLog *thisClass = Get();
+    if (thisClass == nullptr) {
+        return;
+    }
+    thisClass->mutexRings.lock();
+    thisClass->writer->mutex.lock();
+}
+
+void HdcAsyncLog::AtForkParent()
+{
+    HdcAsyncLog *thisClass = Get();
+    if (thisClass == nullptr) {
+        return;
+    }
+    thisClass->writer->mutex.unlock();
+    thisClass->mutexRings.unlock();
+}
+
+// only the forking thread survives, writer is started again by the next Append
+void HdcAsyncLog::AtForkChild()
+{
+    HdcAsyncLog *thisClass = Get();
+    if (thisClass == nullptr) {
+        return;
+    }
+    thisClass->mutexRings.unlock();
+    if (!thisClass->running) {
+        thisClass->writer->mutex.unlock();
+        return;
+    }
+    // the parent's writer thread and its waiters are not here, leave that sync object alone
+    thisClass->writer = new WriterSync();
+    thisClass->running = false;
+    thisClass->fileLog = nullptr;  // the stream belongs to parent, leak it rather than flush twice
+}
+#endif
+
+HdcAsyncLog::RingHolder::~RingHolder()
+{
+    if (ring != nullptr) {
+        ring->orphan = true;
+    }
+}
+
+HdcAsyncLog::LogRing *HdcAsyncLog::GetThreadRing()
+{
+    thread_local RingHolder holder;
+    if (holder.ring != nullptr) {
+        return holder.ring.get();
+    }
+    std::shared_ptr<LogRing> ring = std::make_shared<LogRing>();
+    ring->buf = new(std::nothrow) uint8_t[LOG_RING_SIZE];
+    if (ring->buf == nullptr) {
+        return nullptr;
+    }
+    ring->size = LOG_RING_SIZE;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->orphan = false;
+    {
+        std::lock_guard<std::mutex> lock(mutexRings);
+        vecRings.push_back(ring);
+    }
+    holder.ring = ring;
+    return ring.get();
+}
+
+bool HdcAsyncLog::StartWriter()
+{
+    std::lock_guard<std::mutex> lock(writer->mutex);
+    if (running) {
+        return true;
+    }
+    if (stopping) {
+        return false;
+    }
+    writer->thread = std::thread([this]() { WriterThread(); });
+    running = true;
+    return true;
+}
+
+bool HdcAsyncLog::Append(const uint8_t logLevel, const string &line)
+{
+    return Push(logLevel, line.c_str(), line.size(), false) >= 0;
+}
+
+bool HdcAsyncLog::AppendEntry(const uint8_t logLevel, HdcLogEntry *entry)
+{
+    int ret = Push(logLevel, &entry, sizeof(entry), true);
+    if (ret == 0) {
+        delete entry;  // dropped
+    }
+    return ret >= 0;
+}
+
+// Returns <0 writer unavailable; 0 dropped; >0 queued
+int HdcAsyncLog::Push(const uint8_t logLevel, const void *data, uint32_t len, bool entry)
+{
+    if (!running && !StartWriter()) {
+        return -1;
+    }
+    LogRing *ring = GetThreadRing();
+    if (ring == nullptr) {
+        return -1;
+    }
+    // record is a uint32_t length then the bytes, a line longer than half of the ring is cut
+    len = std::min(static_cast<size_t>(len), ring->size / 2 - sizeof(uint32_t));
+    size_t need = sizeof(uint32_t) + len;
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (ring->size - (tail - ring->head.load(std::memory_order_acquire)) < need) {
+        writer->cond.notify_one();
+        if (logLevel > LOG_WARN) {
+            ++ring->dropped;
+            return 0;
+        }
+        return -1;  // never wait for the writer, the caller writes warnings and errors itself
+    }
+    uint32_t head = entry ? (len | RECORD_ENTRY_FLAG) : len;
+    uint8_t *headBytes = reinterpret_cast<uint8_t *>(&head);
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        ring->buf[(tail + i) % ring->size] = headBytes[i];
+    }
+    size_t pos = (tail + sizeof(uint32_t)) % ring->size;
+    size_t first = std::min(static_cast<size_t>(len), ring->size - pos);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    (void)memcpy_s(ring->buf + pos, ring->size - pos, bytes, first);
+    if (len > first) {
+        (void)memcpy_s(ring->buf, ring->size, bytes + first, len - first);
+    }
+    ring->tail.store(tail + need, std::memory_order_release);
+    if (tail + need - ring->head.load(std::memory_order_relaxed) > ring->size / 2) {
+        writer->cond.notify_one();
+    }
+    return len;
+}
+
+// wait until everything appended before this call is written
+void HdcAsyncLog::Flush()
+{
+    std::unique_lock<std::mutex> lock(writer->mutex);
+    if (!running || writer->thread.get_id() == std::this_thread::get_id()) {
+        return;
+    }
+    uint64_t request = ++flushRequest;
+    writer->cond.notify_one();
+    writer->condFlushed.wait_for(lock, std::chrono::seconds(1), [&]() { return flushDone >= request || !running; });
+}
+
+void HdcAsyncLog::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        if (stopped) {
+            return;
+        }
+        stopping = true;
+    }
+    writer->cond.notify_one();
+    if (writer->thread.joinable()) {
+        writer->thread.join();
+    }
+    stopped = true;
+    running = false;
+}
+
+bool HdcAsyncLog::DrainRings(string &batch)
+{
+    vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutexRings);
+        rings = vecRings;
+    }
+    for (auto &ring : rings) {
+        uint32_t dropped = ring->dropped.exchange(0);
+        if (dropped > 0) {
+            batch += Base::StringFormat("[log] %u lines dropped\n", dropped);
+        }
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+        while (head != tail) {
+            uint32_t len = 0;
+            uint8_t *lenBytes = reinterpret_cast<uint8_t *>(&len);
+            for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+                lenBytes[i] = ring->buf[(head + i) % ring->size];
+            }
+            bool entry = (len & RECORD_ENTRY_FLAG) != 0;
+            len &= ~RECORD_ENTRY_FLAG;
+            string record;
+            size_t pos = (head + sizeof(uint32_t)) % ring->size;
+            size_t first = std::min(static_cast<size_t>(len), ring->size - pos);
+            record.append(reinterpret_cast<char *>(ring->buf + pos), first);
+            record.append(reinterpret_cast<char *>(ring->buf), len - first);
+            head += sizeof(uint32_t) + len;
+            if (!entry) {
+                batch += record;
+                continue;
+            }
+            HdcLogEntry *logEntry = nullptr;
+            if (memcpy_s(&logEntry, sizeof(logEntry), record.data(), record.size()) == EOK && logEntry != nullptr) {
+                batch += logEntry->Format();
+                delete logEntry;
+            }
+        }
+        ring->head.store(head, std::memory_order_release);
+    }
+    // rings of exited threads are released once empty
+    std::lock_guard<std::mutex> lock(mutexRings);
+    for (auto iter = vecRings.begin(); iter != vecRings.end();) {
+        LogRing *ring = iter->get();
+        if (ring->orphan && ring->head.load() == ring->tail.load() && ring->dropped == 0) {
+            delete[] ring->buf;
+            iter = vecRings.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    return !batch.empty();
+}
+
+bool HdcAsyncLog::OpenLogFile()
+{
+    pathIsCache = Base::IsLogCache();
+    pathLog = Base::GetTmpDir() + (pathIsCache ? LOG_CACHE_NAME : LOG_FILE_NAME);
+    fileLog = fopen(pathLog.c_str(), "a");
+    if (fileLog == nullptr) {
+        return false;
+    }
+    (void)fseek(fileLog, 0, SEEK_END);
+    long pos = ftell(fileLog);
+    fileSize = pos > 0 ? static_cast<uint64_t>(pos) : 0;
+    return true;
+}
+
+void HdcAsyncLog::CloseLogFile()
+{
+    if (fileLog != nullptr) {
+        fclose(fileLog);
+        fileLog = nullptr;
+    }
+}
+
+void HdcAsyncLog::RollLogFile()
+{
+    CloseLogFile();
+    string last = Base::StringFormat("%s.%d", pathLog.c_str(), 0);
+    unlink(last.c_str());
+    if (rename(pathLog.c_str(), last.c_str()) != 0) {
+        Base::PrintMessage("RollLogFile error rename %s to %s", pathLog.c_str(), last.c_str());
+    }
+    OpenLogFile();
+}
+
+void HdcAsyncLog::WriteBatch(const string &batch)
+{
+    if (fwrite(batch.c_str(), 1, batch.size(), stdout) > 0) {
+        fflush(stdout);
+    }
+    // RemoveLogFile renames the cache into the log file once, follow it
+    if (fileLog != nullptr && pathIsCache != Base::IsLogCache()) {
+        CloseLogFile();
+    }
+    if (fileLog == nullptr && !OpenLogFile()) {
+        return;
+    }
+    if (fwrite(batch.c_str(), 1, batch.size(), fileLog) > 0) {
+        fflush(fileLog);
+    }
+    fileSize += batch.size();
+    if (!pathIsCache && fileSize >= LOG_FILE_MAX_SIZE) {
+        RollLogFile();
+    }
+}
+
+void HdcAsyncLog::WriterThread()
+{
+    string batch;
+    while (true) {
+        uint64_t request = 0;
+        bool exitWriter = false;
+        {
+            std::unique_lock<std::mutex> lock(writer->mutex);
+            writer->cond.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL),
+                                [&]() { return stopping || flushRequest > flushDone; });
+            request = flushRequest;
+            exitWriter = stopping;
+        }
+        batch.clear();
+        if (DrainRings(batch)) {
+            WriteBatch(batch);
+        }
+        {
+            std::lock_guard<std::mutex> lock(writer->mutex);
+            flushDone = request;
+        }
+        writer->condFlushed.notify_all();
+        if (exitWriter) {
+            break;
+        }
+    }
+    CloseLogFile();
+}
+}  // namespace Hdc
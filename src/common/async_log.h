@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_ASYNC_LOG_H
+#define HDC_ASYNC_LOG_H
+#include "common.h"
+
+namespace Hdc {
+// A log call whose arguments are kept by value and formatted by the writer thread, see HDC_LOG_DEFERRED
+class HdcLogEntry {
+public:
+    virtual ~HdcLogEntry() {}
+    virtual string Format() = 0;
+};
+
+// Log lines are formatted by the calling thread and put into its own single-producer ring, a background writer
+// drains all rings, keeps the log file open, writes in batches and rolls the file by size.
+// When a ring is full, LOG_WARN and more severe lines are written synchronously by the caller, ahead of what is still
+// queued, other lines are dropped and counted.
+class HdcAsyncLog {
+public:
+    static HdcAsyncLog *Get();  // nullptr once stopped, caller writes synchronously
+    bool Append(const uint8_t logLevel, const string &line);
+    bool AppendEntry(const uint8_t logLevel, HdcLogEntry *entry);  // takes the entry when returning true
+    void Flush();
+    void Stop();
+    ~HdcAsyncLog();
+
+private:
+    struct LogRing {
+        uint8_t *buf;
+        size_t size;
+        std::atomic<size_t> head;  // consumer position
+        std::atomic<size_t> tail;  // producer position
+        std::atomic<uint32_t> dropped;
+        std::atomic<bool> orphan;  // owner thread exited, free after drain
+    };
+    struct RingHolder {
+        std::shared_ptr<LogRing> ring;
+        ~RingHolder();
+    };
+    // a forked child gets a new one, the parent's may be held by threads the child doesn't have
+    struct WriterSync {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::condition_variable condFlushed;
+        std::thread thread;
+    };
+    HdcAsyncLog();
+    static constexpr uint32_t RECORD_ENTRY_FLAG = 0x80000000;  // record holds a HdcLogEntry pointer
+    LogRing *GetThreadRing();
+    int Push(const uint8_t logLevel, const void *data, uint32_t len, bool entry);
+    bool StartWriter();
+    void WriterThread();
+    bool DrainRings(string &batch);
+    void WriteBatch(const string &batch);
+    bool OpenLogFile();
+    void CloseLogFile();
+    void RollLogFile();
+#ifndef _WIN32
+    static void AtForkPrepare();
+    static void AtForkParent();
+    static void AtForkChild();
+#endif
+
+    std::mutex mutexRings;
+    vector<std::shared_ptr<LogRing>> vecRings;
+    WriterSync *writer;  // never freed, threads may still log while the process exits
+    std::atomic<bool> running;
+    std::atomic<bool> stopped;
+    bool stopping;
+    uint64_t flushRequest;
+    uint64_t flushDone;
+    FILE *fileLog;
+    string pathLog;
+    bool pathIsCache;
+    uint64_t fileSize;
+};
+
+namespace Base {
+    // base.h includes this header before its own declarations
+    int64_t GetLogTimeNow();
+    size_t GetLogThreadHash();
+    string BuildLogLine(const char *functionName, int line, uint8_t logLevel, int64_t msSinceUnix0,
+                        size_t threadHash, const string &logDetail);
+    void WriteLogLine(uint8_t logLevel, const string &logBuf);
+    const string StringFormat(const char * const formater, ...);
+
+    template<typename T> T LogCapture(T value)
+    {
+        return value;
+    }
+    // strings are copied, the pointer may be gone when the entry is formatted
+    inline string LogCapture(const char *value)
+    {
+        return value != nullptr ? value : "(null)";
+    }
+    inline string LogCapture(char *value)
+    {
+        return value != nullptr ? value : "(null)";
+    }
+    // uint8_t buffers are logged with %s too, e.g. the payload of a read
+    inline string LogCapture(const unsigned char *value)
+    {
+        return LogCapture(reinterpret_cast<const char *>(value));
+    }
+    inline string LogCapture(unsigned char *value)
+    {
+        return LogCapture(reinterpret_cast<const char *>(value));
+    }
+    template<typename T> const T &LogExpand(const T &value)
+    {
+        return value;
+    }
+    inline const char *LogExpand(const string &value)
+    {
+        return value.c_str();
+    }
+
+    template<typename... Args> class LogEntryArgs : public HdcLogEntry {
+    public:
+        LogEntryArgs(const char *functionNameIn, int lineIn, uint8_t logLevelIn, const char *msgIn, Args... argsIn)
+            : functionName(functionNameIn), line(lineIn), logLevel(logLevelIn), msg(msgIn), args(argsIn...)
+        {
+            msSinceUnix0 = GetLogTimeNow();
+            threadHash = GetLogThreadHash();
+        }
+        string Format() override
+        {
+            string logDetail = std::apply(
+                [this](const Args &...value) { return StringFormat(msg, LogExpand(value)...); }, args);
+            return BuildLogLine(functionName, line, logLevel, msSinceUnix0, threadHash, logDetail);
+        }
+
+    private:
+        const char *functionName;  // __FILE__ and format string are literals
+        int line;
+        uint8_t logLevel;
+        const char *msg;
+        std::tuple<Args...> args;
+        int64_t msSinceUnix0;
+        size_t threadHash;
+    };
+
+    template<typename... Args>
+    void DeferLogEx(const char *functionName, int line, uint8_t logLevel, const char *msg, Args... args)
+    {
+        using Entry = LogEntryArgs<decltype(LogCapture(args))...>;
+        Entry *entry = new(std::nothrow) Entry(functionName, line, logLevel, msg, LogCapture(args)...);
+        if (entry == nullptr) {
+            return;
+        }
+        HdcAsyncLog *asyncLog = HdcAsyncLog::Get();
+        if (asyncLog != nullptr && asyncLog->AppendEntry(logLevel, entry)) {
+            return;
+        }
+        WriteLogLine(logLevel, entry->Format());
+        delete entry;
+    }
+}  // namespace Base
+}  // namespace Hdc
+
+#endif  // HDC_ASYNC_LOG_H
@@ -41,7 +41,7 @@ namespace Base {
 // Commenting the code will optimize and tune all log codes, and the compilation volume will be greatly reduced
 #define ENABLE_DEBUGLOG
 #ifdef ENABLE_DEBUGLOG
-    void GetLogDebugFunctionName(string &debugInfo, int line, string &threadIdString)
+    void GetLogDebugFunctionName(string &debugInfo, int line, string &threadIdString, size_t threadHash)
     {
         string tmpString = GetFileNameAny(debugInfo);
         debugInfo = StringFormat("%s:%d", tmpString.c_str(), line);
@@ -50,7 +50,7 @@ namespace Base {
             threadIdString = "";
         } else {
             debugInfo = "[" + debugInfo + "]";
-            threadIdString = StringFormat("[%x]", std::hash<std::thread::id> {}(std::this_thread::get_id()));
+            threadIdString = StringFormat("[%x]", threadHash);
         }
     }
 
@@ -74,10 +74,9 @@ namespace Base {
         return true;
     }
 
-    void GetLogLevelAndTime(uint8_t logLevel, string &logLevelString, string &timeString)
+    void GetLogLevelAndTime(uint8_t logLevel, string &logLevelString, string &timeString, int64_t msSinceUnix0)
     {
-        system_clock::time_point timeNow = system_clock::now();          // now time
-        system_clock::duration sinceUnix0 = timeNow.time_since_epoch();  // since 1970
+        milliseconds sinceUnix0(msSinceUnix0);  // since 1970
         time_t sSinceUnix0 = duration_cast<seconds>(sinceUnix0).count();
         std::tm *tim = std::localtime(&sSinceUnix0);
         bool enableAnsiColor = false;
@@ -207,26 +206,49 @@ namespace Base {
         if (logLevel > g_logLevel) {
             return;
         }
-        string debugInfo;
-        string logBuf;
-        string logLevelString;
-        string threadIdString;
-        string sep = "\n";
-        string timeString;
-
         va_list vaArgs;
         va_start(vaArgs, msg);
         string logDetail = Base::StringFormat(msg, vaArgs);
         va_end(vaArgs);
-        if (logDetail.back() == '\n') {
+        string logBuf = BuildLogLine(functionName, line, logLevel, GetLogTimeNow(), GetLogThreadHash(), logDetail);
+        WriteLogLine(logLevel, logBuf);
+    }
+
+    int64_t GetLogTimeNow()
+    {
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    size_t GetLogThreadHash()
+    {
+        return std::hash<std::thread::id> {}(std::this_thread::get_id());
+    }
+
+    // time and thread are taken by the caller, so deferred entries keep the moment they were logged
+    string BuildLogLine(const char *functionName, int line, uint8_t logLevel, int64_t msSinceUnix0,
+                        size_t threadHash, const string &logDetail)
+    {
+        string debugInfo = functionName;
+        string logLevelString;
+        string threadIdString;
+        string timeString;
+        string sep = "\n";
+        if (!logDetail.empty() && logDetail.back() == '\n') {
             sep = "\r\n";
         }
-        debugInfo = functionName;
-        GetLogDebugFunctionName(debugInfo, line, threadIdString);
-        GetLogLevelAndTime(logLevel, logLevelString, timeString);
-        logBuf = StringFormat("[%s][%s]%s%s %s%s", logLevelString.c_str(), timeString.c_str(), threadIdString.c_str(),
-                              debugInfo.c_str(), logDetail.c_str(), sep.c_str());
+        GetLogDebugFunctionName(debugInfo, line, threadIdString, threadHash);
+        GetLogLevelAndTime(logLevel, logLevelString, timeString, msSinceUnix0);
+        return StringFormat("[%s][%s]%s%s %s%s", logLevelString.c_str(), timeString.c_str(), threadIdString.c_str(),
+                            debugInfo.c_str(), logDetail.c_str(), sep.c_str());
+    }
 
+    void WriteLogLine(uint8_t logLevel, const string &logBuf)
+    {
+        HdcAsyncLog *asyncLog = HdcAsyncLog::Get();
+        if (asyncLog != nullptr && asyncLog->Append(logLevel, logBuf)) {
+            return;
+        }
+        // writer has stopped at exit, write the line synchronously
         printf("%s", logBuf.c_str());
         fflush(stdout);
 
@@ -235,8 +257,6 @@ namespace Base {
         } else {
             LogToCache(logBuf.c_str());
         }
-
-        return;
     }
 #else   // else ENABLE_DEBUGLOG.If disabled, the entire output code will be optimized by the compiler
     void PrintLogEx(uint8_t logLevel, char *msg, ...)
@@ -320,6 +340,8 @@ namespace Base {
     }
 
     // xxx must keep sync with uv_loop_close/uv_walk etc.
+    void CloseWorkThreadJobs(uv_loop_t *loop);
+
     bool TryCloseLoop(uv_loop_t *ptrLoop, const char *callerName)
     {
         // UV_RUN_DEFAULT: Runs the event loop until the reference count drops to zero. Always returns zero.
@@ -330,6 +352,7 @@ namespace Base {
         uint8_t closeRetry = 0;
         bool ret = false;
         constexpr int maxRetry = 3;
+        CloseWorkThreadJobs(ptrLoop);
         for (closeRetry = 0; closeRetry < maxRetry; ++closeRetry) {
             if (uv_loop_close(ptrLoop) == UV_EBUSY) {
                 if (closeRetry > 2) {
@@ -513,17 +536,171 @@ namespace Base {
         delete req;
     }
 
+    // Work threads are dedicated OS threads, not libuv threadpool slots. A session worker blocks in its
+    // child loop for the session lifetime, so sharing the threadpool would starve uv_fs/uv_queue_work users.
+    // One thread per job up to the limit; a job over the limit is refused, queued it would only wait for
+    // another session to end.
+    struct WorkThreadJob {
+        uv_async_t asyncFinish;  // wakes the requesting loop to run pFuncAfterThread
+        uv_work_t *req;
+        uv_work_cb pFuncWorkThread;
+        uv_after_work_cb pFuncAfterThread;
+        // all below are protected by the pool mutex
+        bool workDone;
+        bool closing;  // set by the loop thread when it closes asyncFinish, no more uv_async_send after it
+        bool handleClosed;
+        bool afterDone;
+    };
+    struct WorkThreadPool {
+        std::mutex mutex;
+        std::list<WorkThreadJob *> listJob;  // asyncFinish not yet closed, for TryCloseLoop
+        size_t threadLimit = SIZE_SESSION_THREADS;
+        size_t threadRunning = 0;
+    };
+    WorkThreadPool g_workThreadPool;
+
+    void SetWorkThreadLimit(size_t limit)
+    {
+        if (limit < SIZE_SESSION_THREADS_MIN) {
+            limit = SIZE_SESSION_THREADS_MIN;
+        } else if (limit > SIZE_THREAD_POOL_MAX) {
+            limit = SIZE_THREAD_POOL_MAX;
+        }
+        std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+        g_workThreadPool.threadLimit = limit;
+    }
+
+    size_t GetWorkThreadLimit()
+    {
+        std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+        return g_workThreadPool.threadLimit;
+    }
+
+    size_t GetWorkThreadRunning()
+    {
+        std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+        return g_workThreadPool.threadRunning;
+    }
+
+    // job memory is shared by the worker and the loop, whoever finishes last frees it
+    void FreeWorkThreadJob(WorkThreadJob *job)
+    {
+        if (!job->afterDone) {
+            delete job->req;  // the loop is gone, pFuncAfterThread will not free it
+        }
+        delete job;
+    }
+
+    void WorkThreadJobClosed(uv_handle_t *handle)
+    {
+        WorkThreadJob *job = (WorkThreadJob *)handle->data;
+        bool freeJob = false;
+        {
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            job->handleClosed = true;
+            freeJob = job->workDone;
+        }
+        if (freeJob) {
+            FreeWorkThreadJob(job);
+        }
+    }
+
+    // loop thread only, with the pool mutex held
+    void CloseWorkThreadJob(WorkThreadJob *job)
+    {
+        job->closing = true;
+        g_workThreadPool.listJob.remove(job);
+        uv_close((uv_handle_t *)&job->asyncFinish, WorkThreadJobClosed);
+    }
+
+    // the loop is being torn down, its pending jobs must not signal it any more
+    void CloseWorkThreadJobs(uv_loop_t *loop)
+    {
+        std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+        list<WorkThreadJob *> jobs = g_workThreadPool.listJob;
+        for (auto job : jobs) {
+            if (job->asyncFinish.loop == loop) {
+                CloseWorkThreadJob(job);
+            }
+        }
+    }
+
+    void WorkThreadJobFinish(uv_async_t *handle)
+    {
+        WorkThreadJob *job = (WorkThreadJob *)handle->data;
+        if (job->pFuncAfterThread) {
+            job->pFuncAfterThread(job->req, 0);
+        }
+        std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+        job->afterDone = true;
+        if (!job->closing) {
+            CloseWorkThreadJob(job);
+        }
+    }
+
+    void WorkThreadEntry(WorkThreadJob *job)
+    {
+        job->pFuncWorkThread(job->req);
+        bool freeJob = false;
+        {
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            job->workDone = true;
+            if (!job->closing) {
+                uv_async_send(&job->asyncFinish);
+            }
+            freeJob = job->handleClosed;
+            --g_workThreadPool.threadRunning;
+        }
+        if (freeJob) {
+            FreeWorkThreadJob(job);
+        }
+    }
+
     // at the finsh of pFuncAfterThread must free uv_work_t*
     // clang-format off
     int StartWorkThread(uv_loop_t *loop, uv_work_cb pFuncWorkThread,
                         uv_after_work_cb pFuncAfterThread, void *pThreadData)
     {
-        uv_work_t *workThread = new uv_work_t();
-        if (!workThread) {
-            return -1;
+        {
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            if (g_workThreadPool.threadRunning >= g_workThreadPool.threadLimit) {
+                WRITE_LOG(LOG_WARN, "Work threads exhausted, limit:%zu, refuse new session",
+                          g_workThreadPool.threadLimit);
+                return ERR_THREAD_LIMIT;
+            }
+            ++g_workThreadPool.threadRunning;
+        }
+        uv_work_t *workThread = new(std::nothrow) uv_work_t();
+        WorkThreadJob *job = new(std::nothrow) WorkThreadJob();
+        if (!workThread || !job) {
+            delete workThread;
+            delete job;
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            --g_workThreadPool.threadRunning;
+            return ERR_BUF_ALLOC;
         }
         workThread->data = pThreadData;
-        uv_queue_work(loop, workThread, pFuncWorkThread, pFuncAfterThread);
+        workThread->loop = loop;
+        job->req = workThread;
+        job->pFuncWorkThread = pFuncWorkThread;
+        job->pFuncAfterThread = pFuncAfterThread;
+        job->asyncFinish.data = job;
+        // must be called on the thread which runs loop, same as uv_queue_work
+        uv_async_init(loop, &job->asyncFinish, WorkThreadJobFinish);
+        {
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            g_workThreadPool.listJob.push_back(job);
+        }
+        try {
+            std::thread(WorkThreadEntry, job).detach();
+        } catch (...) {
+            WRITE_LOG(LOG_WARN, "Create work thread failed, running:%zu", GetWorkThreadRunning());
+            std::lock_guard<std::mutex> lock(g_workThreadPool.mutex);
+            --g_workThreadPool.threadRunning;
+            job->workDone = true;  // no worker, the close callback frees the job and its req
+            CloseWorkThreadJob(job);
+            return ERR_THREAD_CREATE;
+        }
         return 0;
     }
     // clang-format on
@@ -1365,9 +1542,18 @@ namespace Base {
         g_logCache = enable;
     }
 
+    bool IsLogCache()
+    {
+        return g_logCache;
+    }
+
     void RemoveLogFile()
     {
         if (g_logCache) {
+            HdcAsyncLog *asyncLog = HdcAsyncLog::Get();
+            if (asyncLog != nullptr) {
+                asyncLog->Flush();  // lines of the cache must land before it is renamed
+            }
             string path = GetTmpDir() + LOG_FILE_NAME;
             string bakPath = GetTmpDir() + LOG_BAK_NAME;
             string cachePath = GetTmpDir() + LOG_CACHE_NAME;
@@ -22,6 +22,11 @@ namespace Base {
     extern uint8_t g_logLevel;
     void SetLogLevel(const uint8_t logLevel);
     void PrintLogEx(const char *functionName, int line, uint8_t logLevel, const char *msg, ...);
+    int64_t GetLogTimeNow();
+    size_t GetLogThreadHash();
+    string BuildLogLine(const char *functionName, int line, uint8_t logLevel, int64_t msSinceUnix0,
+                        size_t threadHash, const string &logDetail);
+    void WriteLogLine(uint8_t logLevel, const string &logBuf);
     void PrintMessage(const char *fmt, ...);
     // tcpHandle can't be const as it's passed into uv_tcp_keepalive
     void SetTcpOptions(uv_tcp_t *tcpHandle);
@@ -45,6 +50,9 @@ namespace Base {
                         void *pThreadData);
     // As an uv_work_cb it must keep the same as prototype
     void FinishWorkThread(uv_work_t *req, int status);
+    void SetWorkThreadLimit(size_t limit);
+    size_t GetWorkThreadLimit();
+    size_t GetWorkThreadRunning();
     int GetMaxBufSize();
     bool TryCloseLoop(uv_loop_t *ptrLoop, const char *callerName);
     void TryCloseHandle(const uv_handle_t *handle);
@@ -140,6 +148,7 @@ namespace Base {
     void SetLogCache(bool enable);
     void RemoveLogFile();
     void RemoveLogCache();
+    bool IsLogCache();
     void RollLogFile(const char *path);
     uv_os_sock_t DuplicateUvSocket(uv_tcp_t *tcp);
     bool IsRoot();
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bench.h"
+#include "serial_struct.h"
+
+namespace Hdc {
+HdcBench::HdcBench(HTaskInfo hTaskInfo)
+    : HdcTaskBase(hTaskInfo)
+{
+}
+
+HdcBench::~HdcBench()
+{
+    WRITE_LOG(LOG_DEBUG, "~HdcBench channelId:%u", taskInfo->channelId);
+}
+
+void HdcBench::StopTask()
+{
+    singalStop = true;
+    if (watchStarted) {
+        watchStarted = false;
+        ++refCount;
+        uv_timer_stop(&timerWatch);
+        uv_close((uv_handle_t *)&timerWatch, WatchClose);
+    }
+}
+
+void HdcBench::WatchClose(uv_handle_t *handle)
+{
+    HdcBench *thisClass = (HdcBench *)handle->data;
+    --thisClass->refCount;
+}
+
+// bench [ping|push|pull|duplex] [-s size] [-c concurrency] [-n count] [-t seconds]
+bool HdcBench::SetMasterParameters(const char *command)
+{
+    int argc = 0;
+    char **argv = Base::SplitCommandToArgs(command, &argc);
+    uint64_t size = 0;
+    uint64_t concurrency = 0;
+    uint64_t seconds = 0;
+    map<string, uint64_t *> mapOption = {
+        { "-s", &size }, { "-c", &concurrency }, { "-n", &config.count }, { "-t", &seconds }
+    };
+    bool ret = true;
+    config.mode = BENCH_PING;
+    config.count = 0;
+    for (int i = 0; argv != nullptr && i < argc && ret; ++i) {
+        string arg = argv[i];
+        auto option = mapOption.find(arg);
+        if (arg == "ping") {
+            config.mode = BENCH_PING;
+        } else if (arg == "push") {
+            config.mode = BENCH_PUSH;
+        } else if (arg == "pull") {
+            config.mode = BENCH_PULL;
+        } else if (arg == "duplex") {
+            config.mode = BENCH_DUPLEX;
+        } else if (option != mapOption.end() && i + 1 < argc) {
+            char *end = nullptr;
+            *option->second = strtoull(argv[i + 1], &end, 10);  // 10: decimal
+            if (end == argv[i + 1] || *end != '\0') {
+                LogMsg(MSG_FAIL, "Invalid bench value: %s %s", argv[i], argv[i + 1]);
+                ret = false;
+            }
+            ++i;
+        } else {
+            LogMsg(MSG_FAIL, "Unknown bench option: %s", argv[i]);
+            ret = false;
+        }
+    }
+    if (argv != nullptr) {
+        delete[]((char *)argv);
+    }
+    if (!ret) {
+        return false;
+    }
+    bool ping = config.mode == BENCH_PING;
+    uint32_t sizeMin = ping ? sizeof(uint64_t) : 1;
+    if (size == 0) {
+        size = ping ? BENCH_PING_SIZE_DEFAULT : BENCH_PACKET_SIZE_DEFAULT;
+    }
+    if (concurrency == 0) {
+        concurrency = ping ? 1 : BENCH_CONCURRENCY_DEFAULT;
+    }
+    if (size < sizeMin || size > BENCH_PACKET_SIZE_MAX) {
+        LogMsg(MSG_FAIL, "Bench packet size must be %u-%u bytes", sizeMin, BENCH_PACKET_SIZE_MAX);
+        return false;
+    }
+    if (concurrency > BENCH_CONCURRENCY_MAX) {
+        LogMsg(MSG_FAIL, "Bench concurrency must be 1-%u", BENCH_CONCURRENCY_MAX);
+        return false;
+    }
+    config.packetSize = size;
+    config.concurrency = concurrency;
+    if (seconds > 0) {
+        config.duration = std::min(seconds * TIME_BASE, static_cast<uint64_t>(UINT32_MAX));
+    } else {
+        config.duration = config.count > 0 ? UINT32_MAX : BENCH_DURATION_DEFAULT;  // count only
+    }
+    return true;
+}
+
+bool HdcBench::SlaveStart(uint8_t *payload, const int payloadSize)
+{
+    string serialString(reinterpret_cast<char *>(payload), payloadSize);
+    SerialStruct::ParseFromString(config, serialString);
+    if (config.mode > BENCH_DUPLEX || config.packetSize < 1 || config.packetSize > BENCH_PACKET_SIZE_MAX ||
+        config.concurrency < 1 || config.concurrency > BENCH_CONCURRENCY_MAX) {
+        LogMsg(MSG_FAIL, "Bench config not supported by device");
+        return false;
+    }
+    SendToAnother(CMD_BENCH_READY, nullptr, 0);
+    if (config.mode == BENCH_PULL || config.mode == BENCH_DUPLEX) {
+        bufPacket.resize(config.packetSize);
+        streamSend.active = true;
+        streamSend.command = CMD_BENCH_SOURCE;
+        streamSend.begin = uv_hrtime();
+        SendStream();
+    }
+    return true;
+}
+
+void HdcBench::MasterStart()
+{
+    if (!master || started || reported) {
+        return;
+    }
+    started = true;
+    timeProgress = uv_hrtime();
+    streamSend.begin = timeProgress;
+    bufPacket.resize(config.packetSize);
+    recvActive = config.mode == BENCH_PULL || config.mode == BENCH_DUPLEX;
+    if (config.mode == BENCH_PULL) {
+        return;
+    }
+    streamSend.active = true;
+    streamSend.command = config.mode == BENCH_PING ? CMD_BENCH_PING : CMD_BENCH_SINK;
+    SendStream();
+}
+
+void HdcBench::SendStream()
+{
+    while (streamSend.active && !streamSend.stopped && streamSend.inflight < config.concurrency) {
+        uint64_t now = uv_hrtime();
+        if ((config.count > 0 && streamSend.packets >= config.count) ||
+            now - streamSend.begin >= config.duration * BENCH_NS_PER_MS) {
+            streamSend.stopped = true;
+            break;
+        }
+        if (streamSend.command == CMD_BENCH_PING) {
+            // peer echoes the payload, so the send time comes back with it
+            (void)memcpy_s(bufPacket.data(), bufPacket.size(), &now, sizeof(now));
+        }
+        if (!SendToAnother(streamSend.command, bufPacket.data(), bufPacket.size())) {
+            streamSend.stopped = true;
+            break;
+        }
+        ++streamSend.packets;
+        ++streamSend.inflight;
+    }
+    if (streamSend.active && streamSend.stopped && streamSend.inflight == 0 && !streamSend.finished) {
+        streamSend.finished = true;
+        streamSend.end = uv_hrtime();
+        SendToAnother(CMD_BENCH_FINISH, nullptr, 0);
+        CheckFinish();
+    }
+}
+
+void HdcBench::OnAck()
+{
+    if (streamSend.inflight == 0) {
+        return;
+    }
+    --streamSend.inflight;
+    streamSend.bytes += config.packetSize;
+    timeProgress = uv_hrtime();
+    SendStream();
+}
+
+void HdcBench::OnPong(uint8_t *payload, const int payloadSize)
+{
+    uint64_t sendTime = 0;
+    if (payloadSize < static_cast<int>(sizeof(sendTime))) {
+        return;
+    }
+    (void)memcpy_s(&sendTime, sizeof(sendTime), payload, sizeof(sendTime));
+    vecLatency.push_back(uv_hrtime() - sendTime);
+    OnAck();
+}
+
+void HdcBench::OnSource(const int payloadSize)
+{
+    recvBytes += payloadSize;
+    recvEnd = uv_hrtime();
+    timeProgress = recvEnd;
+    SendToAnother(CMD_BENCH_ACK, nullptr, 0);
+}
+
+void HdcBench::CheckFinish()
+{
+    if (!master || reported) {
+        return;
+    }
+    if ((streamSend.active && !streamSend.finished) || (recvActive && !peerFinished)) {
+        return;
+    }
+    reported = true;
+    BenchSummary();
+    TaskFinish();
+}
+
+void HdcBench::BenchSummary()
+{
+    const char *modeName[] = { "ping", "push", "pull", "duplex" };
+    HSession hSession = taskInfo->ownerSession;
+    string connName = hSession != nullptr ? HdcSessionBase::ConnTypeName(hSession->connType) : "UNKNOW";
+    LogMsg(MSG_OK, "Bench %s over %s, packet:%u bytes concurrency:%u", modeName[config.mode], connName.c_str(),
+           config.packetSize, config.concurrency);
+    if (config.mode == BENCH_PING) {
+        if (vecLatency.empty()) {
+            LogMsg(MSG_FAIL, "No ping reply");
+            return;
+        }
+        std::sort(vecLatency.begin(), vecLatency.end());
+        size_t count = vecLatency.size();
+        // nearest rank
+        auto percentile = [this, count](uint32_t p) -> double {
+            size_t rank = (count * p + 99) / 100;  // 100: percent
+            return static_cast<double>(vecLatency[rank > 0 ? rank - 1 : 0]) / BENCH_NS_PER_MS;
+        };
+        double sum = 0;
+        for (uint64_t ns : vecLatency) {
+            sum += ns;
+        }
+        LogMsg(MSG_OK, "Round trip of %zu packets(ms) min:%.3lf avg:%.3lf p50:%.3lf p90:%.3lf p99:%.3lf max:%.3lf",
+               count, percentile(0), sum / count / BENCH_NS_PER_MS, percentile(50), percentile(90), percentile(99),
+               percentile(100));  // 50 90 99 100: percent
+        return;
+    }
+    auto rate = [this](const char *name, uint64_t bytes, uint64_t ns) {
+        uint64_t nMSec = std::max(ns / BENCH_NS_PER_MS, static_cast<uint64_t>(1));
+        double fRate = static_cast<double>(bytes) / nMSec / TIME_BASE;  // bytes/ms to MB/s
+        LogMsg(MSG_OK, "%s %" PRIu64 " bytes in %" PRIu64 "ms, rate:%.2lfMB/s", name, bytes, nMSec, fRate);
+    };
+    if (config.mode != BENCH_PULL) {
+        rate("Upload", streamSend.bytes, streamSend.end - streamSend.begin);
+    }
+    if (config.mode != BENCH_PUSH) {
+        rate("Download", recvBytes, recvBytes > 0 ? recvEnd - streamSend.begin : 0);
+    }
+}
+
+void HdcBench::StartWatch()
+{
+    timeInit = uv_hrtime();
+    timerWatch.data = this;
+    uv_timer_init(loopTask, &timerWatch);
+    uv_timer_start(&timerWatch, WatchTimer, TIME_BASE, TIME_BASE);
+    watchStarted = true;
+}
+
+// an old daemon drops CMD_BENCH_START silently, and a broken link stops all progress
+void HdcBench::WatchTimer(uv_timer_t *handle)
+{
+    HdcBench *thisClass = (HdcBench *)handle->data;
+    if (thisClass->reported) {
+        uv_timer_stop(handle);
+        return;
+    }
+    uint64_t last = thisClass->started ? thisClass->timeProgress : thisClass->timeInit;
+    if ((uv_hrtime() - last) / BENCH_NS_PER_MS < BENCH_STALL_TIMEOUT) {
+        return;
+    }
+    if (thisClass->started) {
+        thisClass->LogMsg(MSG_FAIL, "Bench stalled, no progress in %ums", BENCH_STALL_TIMEOUT);
+    } else {
+        thisClass->LogMsg(MSG_FAIL, "Device does not answer bench, it may not support it");
+    }
+    thisClass->reported = true;
+    uv_timer_stop(handle);
+    thisClass->TaskFinish();
+}
+
+bool HdcBench::CommandDispatch(const uint16_t command, uint8_t *payload, const int payloadSize)
+{
+    bool ret = true;
+    switch (command) {
+        case CMD_BENCH_INIT: {
+            string param(reinterpret_cast<char *>(payload), payloadSize);
+            if (!SetMasterParameters(param.c_str())) {
+                ret = false;
+                break;
+            }
+            master = true;
+            string configString = SerialStruct::SerializeToString(config);
+            SendToAnother(CMD_BENCH_START, (uint8_t *)configString.c_str(), configString.size());
+            StartWatch();
+            break;
+        }
+        case CMD_BENCH_START:
+            ret = SlaveStart(payload, payloadSize);
+            break;
+        case CMD_BENCH_READY:
+            MasterStart();
+            break;
+        case CMD_BENCH_PING:
+            SendToAnother(CMD_BENCH_PONG, payload, payloadSize);
+            break;
+        case CMD_BENCH_PONG:
+            OnPong(payload, payloadSize);
+            break;
+        case CMD_BENCH_SINK:
+            SendToAnother(CMD_BENCH_ACK, nullptr, 0);
+            break;
+        case CMD_BENCH_SOURCE:
+            OnSource(payloadSize);
+            break;
+        case CMD_BENCH_ACK:
+            OnAck();
+            break;
+        case CMD_BENCH_FINISH:
+            peerFinished = true;
+            CheckFinish();
+            break;
+        default:
+            break;
+    }
+    return ret;
+}
+}  // namespace Hdc
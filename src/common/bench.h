@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_BENCH_H
+#define HDC_BENCH_H
+#include "common.h"
+
+namespace Hdc {
+// Link benchmark over the session of the target. Server side is the master, it parses the command, drives the test
+// and reports to client; daemon side echoes pings, sinks pushed data and sources pulled data.
+// Every packet is acknowledged by peer, so at most 'concurrency' packets of one direction are in flight.
+// Reports use the CMD_KERNEL_ECHO path, test traffic uses CMD_BENCH_*, see define_plus.h.
+class HdcBench : public HdcTaskBase {
+public:
+    enum BenchMode {
+        BENCH_PING,
+        BENCH_PUSH,
+        BENCH_PULL,
+        BENCH_DUPLEX,
+    };
+    struct BenchConfig {
+        uint8_t mode;
+        uint32_t packetSize;
+        uint32_t concurrency;
+        uint64_t count;     // packets per direction, 0 means until duration
+        uint32_t duration;  // ms
+    };
+    HdcBench(HTaskInfo hTaskInfo);
+    virtual ~HdcBench();
+    bool CommandDispatch(const uint16_t command, uint8_t *payload, const int payloadSize);
+    void StopTask();
+
+private:
+    struct BenchStream {
+        bool active;
+        bool stopped;   // count or duration reached, no new packet
+        bool finished;  // stopped and every packet acknowledged
+        uint16_t command;
+        uint64_t packets;
+        uint64_t bytes;  // acknowledged
+        uint32_t inflight;
+        uint64_t begin;  // ns
+        uint64_t end;
+    };
+    bool SetMasterParameters(const char *command);
+    bool SlaveStart(uint8_t *payload, const int payloadSize);
+    void MasterStart();
+    void SendStream();
+    void OnAck();
+    void OnPong(uint8_t *payload, const int payloadSize);
+    void OnSource(const int payloadSize);
+    void CheckFinish();
+    void BenchSummary();
+    void StartWatch();
+    static void WatchTimer(uv_timer_t *handle);
+    static void WatchClose(uv_handle_t *handle);
+
+    BenchConfig config = {};
+    BenchStream streamSend = {};
+    bool master = false;
+    bool started = false;
+    bool recvActive = false;
+    bool peerFinished = false;
+    bool reported = false;
+    uint64_t recvBytes = 0;
+    uint64_t recvEnd = 0;
+    uint64_t timeInit = 0;
+    uint64_t timeProgress = 0;
+    vector<uint64_t> vecLatency;  // ns
+    vector<uint8_t> bufPacket;
+    uv_timer_t timerWatch;
+    bool watchStarted = false;
+};
+}  // namespace Hdc
+
+#endif  // HDC_BENCH_H
@@ -113,6 +113,7 @@ void HdcChannelBase::ReadStream(uv_stream_t *tcp, ssize_t nread, const uv_buf_t
     int indexBuf = 0;
     int childRet = 0;
     bool needExit = false;
+    uint64_t beginNs = 0;
     HChannel hChannel = (HChannel)tcp->data;
     HdcChannelBase *thisClass = (HdcChannelBase *)hChannel->clsChannel;
 
@@ -134,6 +135,7 @@ void HdcChannelBase::ReadStream(uv_stream_t *tcp, ssize_t nread, const uv_buf_t
     } else {
         hChannel->availTailIndex += nread;
     }
+    beginNs = uv_hrtime();
     while (hChannel->availTailIndex > DWORD_SERIALIZE_SIZE) {
         size = ntohl(*(uint32_t *)(hChannel->ioBuf + indexBuf));  // big endian
         if (size <= 0 || (uint32_t)size > HDC_BUF_MAX_BYTES) {
@@ -143,7 +145,10 @@ void HdcChannelBase::ReadStream(uv_stream_t *tcp, ssize_t nread, const uv_buf_t
         if (hChannel->availTailIndex - DWORD_SERIALIZE_SIZE < size) {
             break;
         }
+        hChannel->stat.CountIn(size);
+        uint64_t traceNs = HdcTrace::Begin();
         childRet = thisClass->ReadChannel(hChannel, (uint8_t *)hChannel->ioBuf + DWORD_SERIALIZE_SIZE + indexBuf, size);
+        HdcTrace::Complete("ReadChannel", "channel", traceNs, hChannel->channelId, size);
         if (childRet < 0) {
             if (!hChannel->keepAlive) {
                 needExit = true;
@@ -154,6 +159,7 @@ void HdcChannelBase::ReadStream(uv_stream_t *tcp, ssize_t nread, const uv_buf_t
         hChannel->availTailIndex -= (DWORD_SERIALIZE_SIZE + size);
         indexBuf += DWORD_SERIALIZE_SIZE + size;
     }
+    hChannel->stat.AddTime(hChannel->stat.readNs, beginNs);
     if (indexBuf > 0 && hChannel->availTailIndex > 0) {
         if (memmove_s(hChannel->ioBuf, hChannel->bufSize, hChannel->ioBuf + indexBuf, hChannel->availTailIndex)) {
             needExit = true;
@@ -173,6 +179,7 @@ void HdcChannelBase::WriteCallback(uv_write_t *req, int status)
     HChannel hChannel = (HChannel)req->handle->data;
     --hChannel->ref;
     HdcChannelBase *thisClass = (HdcChannelBase *)hChannel->clsChannel;
+    hChannel->stat.bytesQueued -= ntohl(*(uint32_t *)req->data) + DWORD_SERIALIZE_SIZE;
     if (status < 0) {
         Base::TryCloseHandle((uv_handle_t *)req->handle);
         if (!hChannel->isDead && !hChannel->ref) {
@@ -278,7 +285,16 @@ void HdcChannelBase::SendChannel(HChannel hChannel, uint8_t *bufPtr, const int s
     }
     if (!uv_is_closing((const uv_handle_t *)sendStream) && uv_is_writable(sendStream)) {
         ++hChannel->ref;
-        Base::SendToStreamEx(sendStream, data, sizeNewBuf, nullptr, (void *)WriteCallback, data);
+        hChannel->stat.CountOut(size);
+        hChannel->stat.bytesQueued += sizeNewBuf;
+        uint64_t beginNs = uv_hrtime();
+        if (Base::SendToStreamEx(sendStream, data, sizeNewBuf, nullptr, (void *)WriteCallback, data) < 0) {
+            // WriteCallback never comes for a write that was not accepted
+            --hChannel->ref;
+            hChannel->stat.bytesQueued -= sizeNewBuf;
+            delete[] data;
+        }
+        hChannel->stat.AddTime(hChannel->stat.writeNs, beginNs);
     } else {
         delete[] data;
     }
@@ -337,6 +353,7 @@ uint32_t HdcChannelBase::MallocChannel(HChannel *hOutChannel)
     hChannel->channelId = channelId;
     (void)memset_s(&hChannel->hChildWorkTCP, sizeof(hChannel->hChildWorkTCP), 0, sizeof(uv_tcp_t));
     AdminChannel(OP_ADD, channelId, hChannel);
+    HdcTrace::Instant("channel_new", "channel", channelId);
     *hOutChannel = hChannel;
     WRITE_LOG(LOG_DEBUG, "Mallocchannel:%u", channelId);
     return channelId;
@@ -422,6 +439,7 @@ void HdcChannelBase::FreeChannel(const uint32_t channelId)
             break;
         }
         WRITE_LOG(LOG_DEBUG, "Begin to free channel, channelid:%u", channelId);
+        HdcTrace::Instant("channel_free", "channel", channelId);
         Base::TimerUvTask(loopMain, hChannel, FreeChannelOpeate, MINOR_TIMEOUT);  // do immediately
         hChannel->isDead = true;
     } while (false);
@@ -441,21 +459,26 @@ HChannel HdcChannelBase::AdminChannel(const uint8_t op, const uint32_t channelId
             mapChannel.erase(channelId);
             uv_rwlock_wrunlock(&lockMapChannel);
             break;
-        case OP_QUERY:
+        case OP_QUERY: {
             uv_rwlock_rdlock(&lockMapChannel);
-            if (mapChannel.count(channelId)) {
-                hRet = mapChannel[channelId];
+            auto iter = mapChannel.find(channelId);
+            if (iter != mapChannel.end()) {
+                hRet = iter->second;
             }
             uv_rwlock_rdunlock(&lockMapChannel);
             break;
-        case OP_QUERY_REF:
-            uv_rwlock_wrlock(&lockMapChannel);
-            if (mapChannel.count(channelId)) {
-                hRet = mapChannel[channelId];
+        }
+        case OP_QUERY_REF: {
+            // ref is atomic, removal needs the write lock, so a read lock is enough here
+            uv_rwlock_rdlock(&lockMapChannel);
+            auto iter = mapChannel.find(channelId);
+            if (iter != mapChannel.end()) {
+                hRet = iter->second;
                 ++hRet->ref;
             }
-            uv_rwlock_wrunlock(&lockMapChannel);
+            uv_rwlock_rdunlock(&lockMapChannel);
             break;
+        }
         case OP_UPDATE:
             uv_rwlock_wrlock(&lockMapChannel);
             // remove old
@@ -485,7 +508,13 @@ void HdcChannelBase::EchoToClient(HChannel hChannel, uint8_t *bufPtr, const int
     sendStream = (uv_stream_t *)&hChannel->hChildWorkTCP;
     if (!uv_is_closing((const uv_handle_t *)sendStream) && uv_is_writable(sendStream)) {
         ++hChannel->ref;
-        Base::SendToStreamEx(sendStream, data, sizeNewBuf, nullptr, (void *)WriteCallback, data);
+        hChannel->stat.CountOut(size);
+        hChannel->stat.bytesQueued += sizeNewBuf;
+        if (Base::SendToStreamEx(sendStream, data, sizeNewBuf, nullptr, (void *)WriteCallback, data) < 0) {
+            --hChannel->ref;
+            hChannel->stat.bytesQueued -= sizeNewBuf;
+            delete[] data;
+        }
     } else {
         WRITE_LOG(LOG_WARN, "EchoToClient, channelId:%u is unwritable.", hChannel->channelId);
         delete[] data;
@@ -502,4 +531,32 @@ void HdcChannelBase::EchoToAllChannelsViaSessionId(uint32_t targetSessionId, con
         }
     }
 }
+
+// one line per channel, all channels when targetSessionId is 0
+string HdcChannelBase::DumpChannelStat(const uint32_t targetSessionId)
+{
+    string ret;
+    uv_rwlock_rdlock(&lockMapChannel);
+    for (auto &v : mapChannel) {
+        HChannel hChannel = v.second;
+        if (hChannel->isDead || (targetSessionId != 0 && hChannel->targetSessionId != targetSessionId)) {
+            continue;
+        }
+        ret += Base::StringFormat("channel %u session %u %s %s\n", hChannel->channelId, hChannel->targetSessionId,
+                                  hChannel->connectKey.c_str(), hChannel->stat.ToString().c_str());
+    }
+    uv_rwlock_rdunlock(&lockMapChannel);
+    return ret;
+}
+
+// session is being freed, channels fall back to the session index lookup
+void HdcChannelBase::DropTargetSession(const HSession hSession)
+{
+    uv_rwlock_rdlock(&lockMapChannel);
+    for (auto &v : mapChannel) {
+        HSession expected = hSession;
+        v.second->targetSession.compare_exchange_strong(expected, nullptr);
+    }
+    uv_rwlock_rdunlock(&lockMapChannel);
+}
 }
@@ -28,6 +28,8 @@ public:
     void WorkerPendding();
     void FreeChannel(const uint32_t channelId);
     void EchoToAllChannelsViaSessionId(uint32_t targetSessionId, const string &echo);
+    string DumpChannelStat(const uint32_t targetSessionId);
+    void DropTargetSession(const HSession hSession);
     vector<uint8_t> GetChannelHandshake(string &connectKey) const;
 
 protected:
@@ -73,7 +75,7 @@ private:
     uint32_t GetChannelPseudoUid();
 
     uv_rwlock_t lockMapChannel;  // protect mapChannel
-    map<uint32_t, HChannel> mapChannel;
+    std::unordered_map<uint32_t, HChannel> mapChannel;
     uv_thread_t threadChanneMain;
 };
 }  // namespace Hdc
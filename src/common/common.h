@@ -24,6 +24,7 @@
 #include <mutex>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <assert.h>
@@ -66,9 +67,13 @@ using std::vector;
 #include "define.h"
 #include "debug.h"
 #include "base.h"
+#include "async_log.h"
+#include "latency.h"
+#include "trace.h"
 #include "task.h"
 #include "channel.h"
 #include "session.h"
+#include "send_queue.h"
 #include "auth.h"
 
 #include "tcp.h"
@@ -77,6 +82,8 @@ using std::vector;
 #include "uart.h"
 #endif
 #include "file_descriptor.h"
+#include "shell_pool.h"
+#include "loopback.h"
 
 // clang-format on
 
@@ -23,6 +23,14 @@ constexpr size_t SIZE_THREAD_POOL = 16;
 #endif
 constexpr size_t SIZE_THREAD_POOL_MIN = 16;
 constexpr size_t SIZE_THREAD_POOL_MAX = 256;
+// dedicated session work threads, one per live session, independent of the uv threadpool
+#ifdef HDC_HOST
+constexpr size_t SIZE_SESSION_THREADS = 128;  // the server serves every attached device, as many as its old uv pool
+#else
+constexpr size_t SIZE_SESSION_THREADS = 64;
+#endif
+constexpr size_t SIZE_SESSION_THREADS_MIN = 4;
+constexpr uint8_t SESSION_MAP_SHARDS = 16;  // must be power of 2
 constexpr uint8_t GLOBAL_TIMEOUT = 30;
 constexpr uint16_t DEFAULT_PORT = 8710;
 constexpr bool ENABLE_IO_CHECKSUM = false;
@@ -30,6 +38,11 @@ const string IPV4_MAPPING_PREFIX = "::ffff:";
 const string DEFAULT_SERVER_ADDR_IP = "::ffff:127.0.0.1";
 const string DEFAULT_SERVER_ADDR = "::ffff:127.0.0.1:8710";
 const string ENV_SERVER_PORT = "OHOS_HDC_SERVER_PORT";
+const string ENV_UV_THREADS = "OHOS_HDC_UV_THREADS";
+const string ENV_SESSION_THREADS = "OHOS_HDC_SESSION_THREADS";
+const string ENV_SESSION_LOOPS = "OHOS_HDC_SESSION_LOOPS";  // unset: loop per session, 0: loop per core, N: N loops
+const string ENV_TRACE = "OHOS_HDC_TRACE";  // path of the chrome trace file, unset: tracing off
+const string ENV_FORWARD_BACKLOG = "OHOS_HDC_FORWARD_BACKLOG";  // listen backlog of fport/rport listeners
 
 // ################################ macro define ###################################
 constexpr uint8_t MINOR_TIMEOUT = 5;
@@ -59,13 +72,50 @@ constexpr uint16_t MAX_USBFFS_BULK = 16384;
 constexpr uint32_t HDC_VERSION_NUMBER = 0x10102000;  // 1.1.2a=0x10102000
 constexpr uint32_t HDC_BUF_MAX_BYTES = INT_MAX;
 constexpr uint32_t HDC_SOCKETPAIR_SIZE = MAX_SIZE_IOBUF * 10;
+constexpr uint32_t SEND_WINDOW_DEFAULT = 1048576;  // per-channel receive window announced to peer
+constexpr uint32_t SEND_INFLIGHT_MAX = 262144;     // TCP bytes queued in libuv before session send queue holds
+constexpr uint32_t SESSION_WRITE_HIGH_WATERMARK = 4194304;  // pending session bytes that pause readers
+constexpr uint32_t SESSION_WRITE_LOW_WATERMARK = 1048576;   // pending session bytes that resume readers
+constexpr uint16_t SEND_COALESCE_PACKET_MAX = 1024;        // smaller packets are gathered per loop iteration
+constexpr uint16_t SEND_COALESCE_BATCH_MAX = MAX_SIZE_IOBUF;
+constexpr uint64_t SEND_COALESCE_LATENCY_NS = 1000000;     // first gathered packet waits at most 1ms
+// shell output after a quiet period goes out at once, a burst is gathered up to the size or the latency budget
+constexpr uint16_t SHELL_COALESCE_SIZE = MAX_SIZE_IOBUF;
+constexpr uint64_t SHELL_COALESCE_LATENCY = 2;  // ms
+// warm shell workers per kind, with and without PTY. Off unless persist.hdc.shell.pool is set: a direct start no
+// longer forks the daemon and is not slower than a warm worker
+constexpr uint32_t SHELL_POOL_SIZE_DEFAULT = 0;
+constexpr uint16_t SHELL_POOL_CMD_MAX = BUF_SIZE_DEFAULT4;  // longer commands fork a shell directly
+// one-time AsyncCmd keeps at most the tail of this size, the end of a dump carries the result
+constexpr size_t ASYNCCMD_RESULT_MAX = 262144;
+constexpr uint32_t BATCH_PARALLEL_DEFAULT = 8;  // commands of "hdc batch" running at once
+constexpr uint32_t BATCH_PARALLEL_MAX = 64;
+// one forward socket read, a packet of it still fits the HDC_SOCKETPAIR_SIZE receive buffer of older peers
+constexpr uint32_t FORWARD_READ_BUF_SIZE = MAX_SIZE_IOBUF * 4;
+constexpr int FORWARD_LISTEN_BACKLOG_DEFAULT = 128;
+constexpr uint32_t FORWARD_UDP_IDLE_TIMEOUT = 60000;     // ms, a udp peer without traffic is released
+constexpr uint32_t FORWARD_UDP_SWEEP_INTERVAL = 5000;    // ms
+constexpr uint32_t FORWARD_WRITE_HIGH_WATERMARK = 1048576;  // unwritten bytes of a forward that pause its peer
+constexpr uint32_t FORWARD_WRITE_LOW_WATERMARK = 262144;    // unwritten bytes of a forward that resume its peer
+constexpr uint16_t BENCH_PING_SIZE_DEFAULT = 64;
+constexpr uint16_t BENCH_PACKET_SIZE_DEFAULT = 12288;      // one file transfer IO, fits a single hdc packet
+constexpr uint16_t BENCH_PACKET_SIZE_MAX = 12288;
+constexpr uint16_t BENCH_CONCURRENCY_DEFAULT = 8;
+constexpr uint16_t BENCH_CONCURRENCY_MAX = 1024;
+constexpr uint32_t BENCH_DURATION_DEFAULT = 5000;          // ms
+constexpr uint32_t BENCH_STALL_TIMEOUT = 10000;            // ms without progress before bench gives up
+constexpr uint64_t BENCH_NS_PER_MS = 1000000;
 
 const string WHITE_SPACES = " \t\n\r";
 const string UT_TMP_PATH = "/tmp/hdc-ut";
+const string LOOPBACK_KEY_PREFIX = "loopback-";  // connect key of an in-process daemon, no ':' so not taken as TCP
 const string LOG_FILE_NAME = "hdc.log";
 const string LOG_BAK_NAME = "hdclast.log";
 const string LOG_CACHE_NAME = ".hdc.cache.log";
 constexpr uint64_t LOG_FILE_MAX_SIZE = 104857600;
+constexpr size_t LOG_RING_SIZE = 65536;         // per-thread async log buffer
+constexpr uint16_t LOG_FLUSH_INTERVAL = 50;     // ms, async log writer wakes at least this often
+constexpr size_t TRACE_BUFFER_EVENTS = 4096;    // per-thread trace events kept before written out
 const string SERVER_NAME = "HDCServer";
 const string STRING_EMPTY = "";
 const string HANDSHAKE_MESSAGE = "OHOS HDC";  // sep not char '-', not more than 11 bytes
@@ -93,6 +143,9 @@ const string CMDSTR_STARTUP_MODE = "smode";
 const string CMDSTR_TARGET_MODE = "tmode";
 const string CMDSTR_BUGREPORT = "bugreport";
 const string CMDSTR_HILOG = "hilog";
+const string CMDSTR_BENCH = "bench";
+const string CMDSTR_STAT = "stat";
+const string CMDSTR_BATCH = "batch";
 const string CMDSTR_TMODE_USB = "usb";
 #ifdef HDC_SUPPORT_UART
 const string CMDSTR_TMODE_UART = "uart";
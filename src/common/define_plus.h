@@ -30,7 +30,22 @@ enum LogLevel {
     LOG_VERBOSE,
     LOG_LAST = LOG_VERBOSE,  // tail, not use
 };
-#define WRITE_LOG(x, y...) Base::PrintLogEx(__FILE__, __LINE__, x, y)
+// Levels above HDC_LOG_COMPILE_LEVEL are removed at build time, and the runtime level is checked before any
+// argument is evaluated. With HDC_LOG_DEFERRED the arguments are kept by value and formatted by the log writer.
+#ifndef HDC_LOG_COMPILE_LEVEL
+#define HDC_LOG_COMPILE_LEVEL LOG_LAST
+#endif
+#ifdef HDC_LOG_DEFERRED
+#define HDC_LOG_CALL Base::DeferLogEx
+#else
+#define HDC_LOG_CALL Base::PrintLogEx
+#endif
+#define WRITE_LOG(x, y...)                                                 \
+    do {                                                                   \
+        if ((x) <= HDC_LOG_COMPILE_LEVEL && (x) <= Base::g_logLevel) {     \
+            HDC_LOG_CALL(__FILE__, __LINE__, x, y);                        \
+        }                                                                  \
+    } while (false)
 
 enum MessageLevel {
     MSG_FAIL,
@@ -38,7 +53,7 @@ enum MessageLevel {
     MSG_OK,
 };
 
-enum ConnType { CONN_USB = 0, CONN_TCP, CONN_SERIAL, CONN_BT };
+enum ConnType { CONN_USB = 0, CONN_TCP, CONN_SERIAL, CONN_BT, CONN_LOOPBACK };
 
 #ifdef HDC_SUPPORT_UART
 enum UartTimeConst {
@@ -115,6 +130,8 @@ enum RetErrCode {
     ERR_UT_MODULE_NOTREADY = -19000,
     ERR_UT_MODULE_WAITMAX,
     ERR_THREAD_MUTEX_FAIL = -20000,
+    ERR_THREAD_LIMIT,
+    ERR_THREAD_CREATE,
     ERR_PROCESS_SUB_FAIL = -21000,
     ERR_PRIVELEGE_NEED = -22000,
 };
@@ -124,6 +141,7 @@ enum AsyncEvent {
     ASYNC_STOP_MAINLOOP = 0,
     ASYNC_FREE_SESSION,
     ASYNC_FREE_CHANNEL,
+    ASYNC_SESSION_CTRL,  // session work thread to main, replace ctrlPipe when the session has none
 };
 enum InnerCtrlCommand {
     SP_START_SESSION = 0,
@@ -131,6 +149,15 @@ enum InnerCtrlCommand {
     SP_ATTACH_CHANNEL,
     SP_DEATCH_CHANNEL,
     SP_JDWP_NEWFD,
+    SP_FLUSH_SEND_QUEUE,  // packets sent from main thread are waiting in the session send queue
+};
+// Latency histograms kept by HdcLatency
+enum HdcLatencyPoint {
+    LAT_CLIENT_ECHO = 0,  // client command read by server until the first echo to client
+    LAT_SESSION_WRITE,    // packet queued on the session until it is handed to the transport
+    LAT_USB_TRANSFER,     // host usb bulk out submitted until completed
+    LAT_TASK_FIRST_DATA,  // task created until it sends its first packet
+    LAT_POINT_COUNT,
 };
 
 enum HdcCommand {
@@ -148,6 +175,8 @@ enum HdcCommand {
     CMD_KERNEL_ECHO_RAW,
     CMD_KERNEL_ENABLE_KEEPALIVE,
     CMD_KERNEL_WAKEUP_SLAVETASK,
+    CMD_KERNEL_WINDOW_UPDATE,
+    CMD_KERNEL_STAT,  // server side only, see CMD_UNITY_STAT for the daemon side
     // One-pass simple commands
     CMD_UNITY_COMMAND_HEAD = 1000,  // not use
     CMD_UNITY_EXECUTE,
@@ -163,6 +192,8 @@ enum HdcCommand {
     // It will be separated from unity in the near future
     CMD_UNITY_BUGREPORT_INIT,
     CMD_UNITY_BUGREPORT_DATA,
+    CMD_UNITY_STAT,
+    CMD_UNITY_BATCH_EXECUTE,  // many shell commands run concurrently, output comes back as tagged records
     // Shell commands types
     CMD_SHELL_INIT = 2000,
     CMD_SHELL_DATA,
@@ -177,6 +208,8 @@ enum HdcCommand {
     CMD_FORWARD_LIST,
     CMD_FORWARD_REMOVE,
     CMD_FORWARD_SUCCESS,
+    CMD_FORWARD_PAUSE,  // peer stops reading the source of a context until CMD_FORWARD_RESUME
+    CMD_FORWARD_RESUME,
     // File commands
     CMD_FILE_INIT = 3000,
     CMD_FILE_CHECK,
@@ -191,6 +224,18 @@ enum HdcCommand {
     CMD_APP_DATA,
     CMD_APP_FINISH,
     CMD_APP_UNINSTALL,
+    // Benchmark commands. Results go to the client over CMD_KERNEL_ECHO like any task, but the packets under test
+    // have their own commands: the server consumes CMD_KERNEL_ECHO(_RAW) before any task and prints it to the client,
+    // so it can't carry a round trip or acknowledged data without changing what existing daemons send.
+    CMD_BENCH_INIT = 4000,
+    CMD_BENCH_START,
+    CMD_BENCH_READY,
+    CMD_BENCH_PING,
+    CMD_BENCH_PONG,
+    CMD_BENCH_SINK,    // host to daemon data, discarded by daemon
+    CMD_BENCH_SOURCE,  // daemon to host data
+    CMD_BENCH_ACK,
+    CMD_BENCH_FINISH,
 
     // deprecated, remove later
     CMD_UNITY_JPID = CMD_JDWP_LIST,
@@ -227,6 +272,7 @@ struct TaskInformation {
     uint8_t taskType;
     uint32_t sessionId;
     uint32_t channelId;
+    struct HdcSession *ownerSession;  // resolved at creation, task never outlives its session
     bool hasInitial;
     bool taskStop;
     bool taskFree;
@@ -236,6 +282,12 @@ struct TaskInformation {
     void *taskClass;
     void *ownerSessionClass;
     uint32_t closeRetryCount;
+    // traffic of this task, only touched on the session work thread
+    uint64_t packetsIn;
+    uint64_t bytesIn;
+    uint64_t packetsOut;
+    uint64_t bytesOut;
+    uint64_t createNs;  // cleared once the task sends its first packet
 };
 using HTaskInfo = TaskInformation *;
 
@@ -251,6 +303,7 @@ struct HostUSBEndpoint {
         isShutdown = true;
         isComplete = true;
         bulkInOut = false;
+        submitNs = 0;
         (void)memset_s(buf, sizeEpBuf, 0, sizeEpBuf);
     }
     ~HostUSBEndpoint()
@@ -263,6 +316,7 @@ struct HostUSBEndpoint {
     bool isShutdown;
     bool bulkInOut;  // true is bulkIn
     uint16_t sizeEpBuf;
+    uint64_t submitNs;  // bulk out submitted, 0 for reads which wait on the device
     mutex mutexIo;
     mutex mutexCb;
     condition_variable cv;
@@ -326,6 +380,57 @@ struct HdcUART {
 using HUART = struct HdcUART *;
 #endif
 
+struct HdcLoopbackLink;
+// one end of an in-process link, see loopback.h
+struct HdcLoopbackEnd {
+    std::shared_ptr<HdcLoopbackLink> link;
+    uint8_t side = 0;            // STREAM_MAIN server end, STREAM_WORK daemon end
+    uv_async_t asyncRead = {};   // wakes the session work loop when the peer appended data
+};
+using HLoopback = struct HdcLoopbackEnd *;
+
+// Traffic counters dumped by "hdc stat". Only the owner thread updates them, relaxed atomics are enough for a reader
+// on another thread.
+struct HdcTrafficStat {
+    std::atomic<uint64_t> packetsIn = 0;
+    std::atomic<uint64_t> bytesIn = 0;
+    std::atomic<uint64_t> packetsOut = 0;
+    std::atomic<uint64_t> bytesOut = 0;
+    std::atomic<uint64_t> bytesQueued = 0;  // accepted for write, not written yet
+    std::atomic<uint64_t> retransmits = 0;  // UART packages sent again
+    std::atomic<uint64_t> usbErrors = 0;    // failed USB transfers
+    std::atomic<uint64_t> readNs = 0;       // time spent handling reads
+    std::atomic<uint64_t> writeNs = 0;      // time spent issuing writes
+    void CountIn(const uint64_t bytes)
+    {
+        packetsIn.fetch_add(1, std::memory_order_relaxed);
+        bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void CountOut(const uint64_t bytes)
+    {
+        packetsOut.fetch_add(1, std::memory_order_relaxed);
+        bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void AddTime(std::atomic<uint64_t> &counter, const uint64_t beginNs)
+    {
+        counter.fetch_add(uv_hrtime() - beginNs, std::memory_order_relaxed);
+    }
+    std::string ToString() const
+    {
+        constexpr uint64_t nsPerUs = 1000;
+        std::ostringstream oss;
+        oss << "in:" << packetsIn << "/" << bytesIn << "B";
+        oss << " out:" << packetsOut << "/" << bytesOut << "B";
+        oss << " queued:" << bytesQueued << "B";
+        oss << " retrans:" << retransmits;
+        oss << " usberr:" << usbErrors;
+        oss << " read:" << readNs / nsPerUs << "us";
+        oss << " write:" << writeNs / nsPerUs << "us";
+        return oss.str();
+    }
+};
+
+class HdcSendQueue;
 struct HdcSession {
     bool serverOrDaemon;  // instance of daemon or server
     bool handshakeOK;     // Is an expected peer side
@@ -352,6 +457,9 @@ struct HdcSession {
     string tokenRSA;  // SHA_DIGEST_LENGTH+1==21
     // child work
     uv_loop_t childLoop;  // run in work thread
+    // TCP session runs on a loop shard, shared in M:N mode or private, childLoop/ctrlPipe/dataPipe are unused
+    void *loopShard;
+    uv_loop_t *sharedLoop;
     // pipe0 in main thread(hdc server mainloop), pipe1 in work thread
     uv_tcp_t ctrlPipe[2];  // control channel
     int ctrlFd[2];         // control channel socketpair
@@ -365,10 +473,19 @@ struct HdcSession {
 #ifdef HDC_SUPPORT_UART
     HUART hUART = nullptr;
 #endif
+    // loopback handle
+    HLoopback hLoopback;
     // tcp handle
     uv_tcp_t hWorkTCP;
     uv_thread_t hWorkThread;
     uv_thread_t hWorkChildThread;
+    // priority and credit scheduling of packets, main thread sends are handed over by PushRemote
+    HdcSendQueue *sendQueue;
+    HdcTrafficStat stat;
+    uv_loop_t *GetWorkLoop()
+    {
+        return sharedLoop != nullptr ? sharedLoop : &childLoop;
+    }
     std::string ToDebugString()
     {
         std::ostringstream oss;
@@ -405,6 +522,10 @@ struct HdcSession {
         authKeyIndex = 0;
         tokenRSA = "";
         hUSB = nullptr;
+        hLoopback = nullptr;
+        loopShard = nullptr;
+        sharedLoop = nullptr;
+        sendQueue = nullptr;
 #ifdef HDC_SUPPORT_UART
         hUART = nullptr;
 #endif
@@ -439,6 +560,7 @@ struct HdcChannel {
     bool keepAlive;             // channel will not auto-close by server
     std::atomic<uint32_t> ref;
     uint32_t targetSessionId;
+    std::atomic<HSession> targetSession = nullptr;  // set by main thread only, dropped once the session starts to free
     // child work
     uv_tcp_t hChildWorkTCP;  // work channel for server, no use in client
     uv_os_sock_t fdChildWorkTCP;
@@ -446,6 +568,8 @@ struct HdcChannel {
     int bufSize;         // total buffer size
     int availTailIndex;  // buffer available data size
     uint8_t *ioBuf;
+    HdcTrafficStat stat;
+    std::atomic<uint64_t> commandBeginNs = 0;  // last client command read by server, cleared by its first echo
     // std
     uv_tty_t stdinTty;
     uv_tty_t stdoutTty;
@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 #include "file_descriptor.h"
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 namespace Hdc {
 HdcFileDescriptor::HdcFileDescriptor(uv_loop_t *loopIn, int fdToRead, void *callerContextIn,
@@ -20,11 +23,22 @@ HdcFileDescriptor::HdcFileDescriptor(uv_loop_t *loopIn, int fdToRead, void *call
 {
     loop = loopIn;
     workContinue = true;
+    readPaused = false;
+    readHeld = false;
     callbackFinish = callbackFinishIn;
     callbackRead = callbackReadIn;
     fdIO = fdToRead;
     refIO = 0;
     callerContext = callerContextIn;
+    readBuf = nullptr;
+    readMax = 0;
+    pollEvents = 0;
+    pollChecked = false;
+    pollMode = false;
+    pollReading = false;
+    pollClosing = false;
+    finishReported = false;
+    closeFdIo = false;
 }
 
 HdcFileDescriptor::~HdcFileDescriptor()
@@ -32,6 +46,10 @@ HdcFileDescriptor::~HdcFileDescriptor()
     if (refIO > 0) {
         WRITE_LOG(LOG_FATAL, "~HdcFileDescriptor refIO > 0");
     }
+    for (auto &item : listWrite) {
+        delete[] item.buf;
+    }
+    delete[] readBuf;
 }
 
 bool HdcFileDescriptor::ReadyForRelease()
@@ -44,6 +62,17 @@ void HdcFileDescriptor::StopWork(bool tryCloseFdIo, std::function<void()> closeF
 {
     workContinue = false;
     callbackCloseFd = closeFdCallback;
+    if (pollMode) {
+        closeFdIo = tryCloseFdIo;
+        ClosePoll();
+        return;
+    }
+    if (readHeld) {
+        // keep a read in flight as before pausing, so close and finish callbacks still happen
+        readPaused = false;
+        readHeld = false;
+        LoopRead();
+    }
     if (tryCloseFdIo && refIO > 0) {
         ++refIO;
         reqClose.data = this;
@@ -73,6 +102,10 @@ void HdcFileDescriptor::OnFileIO(uv_fs_t *req)
                     bFinish = true;
                     break;
                 }
+                if (thisClass->readPaused) {
+                    thisClass->readHeld = true;
+                    break;
+                }
                 thisClass->LoopRead();
             } else {
                 // fs_write
@@ -100,6 +133,28 @@ void HdcFileDescriptor::OnFileIO(uv_fs_t *req)
     }
 }
 
+void HdcFileDescriptor::PauseRead()
+{
+    readPaused = true;
+    if (pollMode) {
+        UpdatePollEvents();
+    }
+}
+
+void HdcFileDescriptor::ResumeRead()
+{
+    readPaused = false;
+    if (pollMode) {
+        UpdatePollEvents();
+        return;
+    }
+    if (!readHeld) {
+        return;
+    }
+    readHeld = false;
+    LoopRead();
+}
+
 int HdcFileDescriptor::LoopRead()
 {
     uv_buf_t iov;
@@ -127,8 +182,180 @@ int HdcFileDescriptor::LoopRead()
     return 0;
 }
 
+// pollable fds only, a regular file always reads ready and epoll refuses it
+bool HdcFileDescriptor::SetupPoll()
+{
+    if (pollChecked) {
+        return pollMode;
+    }
+    pollChecked = true;
+#ifndef _WIN32
+    struct stat st;
+    if (fdIO < 0 || fstat(fdIO, &st) != 0) {
+        return false;
+    }
+    if (!S_ISCHR(st.st_mode) && !S_ISFIFO(st.st_mode) && !S_ISSOCK(st.st_mode)) {
+        return false;
+    }
+    readMax = Base::GetMaxBufSize() * 1.2;
+    readBuf = new(std::nothrow) uint8_t[readMax];
+    if (readBuf == nullptr) {
+        return false;
+    }
+    // uv_poll_init switches the fd to nonblocking, a device without poll support stays on the threadpool
+    int ret = uv_poll_init(loop, &pollIO, fdIO);
+    if (ret != 0) {
+        WRITE_LOG(LOG_DEBUG, "SetupPoll fd:%d not pollable:%s, use threadpool", fdIO, uv_strerror(ret));
+        delete[] readBuf;
+        readBuf = nullptr;
+        return false;
+    }
+    pollIO.data = this;
+    ++refIO;  // released by the close callback of pollIO
+    pollMode = true;
+#endif
+    return pollMode;
+}
+
+void HdcFileDescriptor::UpdatePollEvents()
+{
+    if (pollClosing) {
+        return;
+    }
+    int events = 0;
+    if (pollReading && !readPaused) {
+        events |= UV_READABLE | UV_DISCONNECT;
+    }
+    if (!listWrite.empty()) {
+        events |= UV_WRITABLE;
+    }
+    if (events == pollEvents) {
+        return;
+    }
+    pollEvents = events;
+    if (events == 0) {
+        uv_poll_stop(&pollIO);
+    } else {
+        uv_poll_start(&pollIO, events, OnPollIO);
+    }
+}
+
+void HdcFileDescriptor::OnPollIO(uv_poll_t *handle, int status, int events)
+{
+    HdcFileDescriptor *thisClass = (HdcFileDescriptor *)handle->data;
+    if (status < 0) {
+        WRITE_LOG(LOG_DEBUG, "OnPollIO fd:%d failed:%s", thisClass->fdIO, uv_strerror(status));
+        thisClass->FinishPoll(true, STRING_EMPTY);
+        return;
+    }
+    if (events & UV_WRITABLE) {
+        thisClass->PollWriteQueue();
+    }
+    if (events & (UV_READABLE | UV_DISCONNECT)) {
+        thisClass->PollRead();
+    }
+}
+
+// drains what is readable now, bounded so one busy fd cannot starve the loop, level triggered polling comes back
+void HdcFileDescriptor::PollRead()
+{
+    constexpr int maxReadsPerEvent = 16;
+    for (int i = 0; i < maxReadsPerEvent && !pollClosing && !readPaused; ++i) {
+        ssize_t rc = read(fdIO, readBuf, readMax);
+        if (rc > 0) {
+            if (!callbackRead(callerContext, readBuf, rc)) {
+                FinishPoll(false, STRING_EMPTY);
+                return;
+            }
+            continue;
+        }
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (rc < 0) {
+            // EIO is the normal end of a PTY whose slave side has been closed
+            WRITE_LOG(LOG_DEBUG, "PollRead fd:%d failed:%s", fdIO, strerror(errno));
+        }
+        FinishPoll(true, STRING_EMPTY);
+        return;
+    }
+}
+
+void HdcFileDescriptor::PollWriteQueue()
+{
+    while (!listWrite.empty()) {
+        PollWrite &item = listWrite.front();
+        ssize_t rc = write(fdIO, item.buf + item.offset, item.size - item.offset);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            WRITE_LOG(LOG_DEBUG, "PollWriteQueue fd:%d failed:%s", fdIO, strerror(errno));
+            FinishPoll(true, STRING_EMPTY);
+            return;
+        }
+        item.offset += rc;
+        if (item.offset < item.size) {
+            continue;
+        }
+        delete[] item.buf;
+        listWrite.pop_front();
+    }
+    UpdatePollEvents();
+}
+
+void HdcFileDescriptor::FinishPoll(const bool fetal, const string &msg)
+{
+    if (finishReported) {
+        return;
+    }
+    finishReported = true;
+    workContinue = false;
+    ClosePoll();
+    callbackFinish(callerContext, fetal, msg);
+}
+
+// a finish not reported yet is reported from the close callback, as the failing read of the threadpool mode would
+void HdcFileDescriptor::ClosePoll()
+{
+    if (pollClosing) {
+        return;
+    }
+    pollClosing = true;
+    uv_poll_stop(&pollIO);
+    uv_close((uv_handle_t *)&pollIO, [](uv_handle_t *handle) {
+        HdcFileDescriptor *thisClass = (HdcFileDescriptor *)handle->data;
+        for (auto &item : thisClass->listWrite) {
+            delete[] item.buf;
+        }
+        thisClass->listWrite.clear();
+        if (!thisClass->finishReported) {
+            thisClass->finishReported = true;
+            thisClass->callbackFinish(thisClass->callerContext, true, STRING_EMPTY);
+        }
+        if (thisClass->closeFdIo) {
+            close(thisClass->fdIO);
+            if (thisClass->callbackCloseFd != nullptr) {
+                thisClass->callbackCloseFd();
+            }
+        }
+        --thisClass->refIO;
+    });
+}
+
 bool HdcFileDescriptor::StartWork()
 {
+    if (SetupPoll()) {
+        pollReading = true;
+        UpdatePollEvents();
+        return true;
+    }
     if (LoopRead() < 0) {
         return false;
     }
@@ -155,6 +382,17 @@ int HdcFileDescriptor::Write(uint8_t *data, int size)
 // Data's memory must be Malloc, and the callback FREE after this function is completed
 int HdcFileDescriptor::WriteWithMem(uint8_t *data, int size)
 {
+    if (SetupPoll()) {
+        if (pollClosing) {
+            delete[] data;
+            return -1;
+        }
+        listWrite.push_back({ data, size, 0 });
+        if (listWrite.size() == 1) {
+            PollWriteQueue();  // nothing waits for writable, try at once
+        }
+        return size;
+    }
     auto contextIO = new CtxFileIO();
     if (!contextIO) {
         delete[] data;
@@ -17,6 +17,8 @@
 #include "common.h"
 
 namespace Hdc {
+// Pipes, PTYs and char devices are read on readiness notifications of the loop into one reused buffer, writes go
+// out directly and only queue on EAGAIN. Regular files, and fds the loop cannot poll, keep the threadpool reads.
 class HdcFileDescriptor {
 public:
     // callerContext, normalFinish, errorString
@@ -32,6 +34,9 @@ public:
     bool ReadyForRelease();
     bool StartWork();
     void StopWork(bool tryCloseFdIo, std::function<void()> closeFdCallback);
+    // hold the next read after the current callbackRead, used for session write backpressure
+    void PauseRead();
+    void ResumeRead();
 
 protected:
 private:
@@ -40,8 +45,20 @@ private:
         uint8_t *bufIO;
         HdcFileDescriptor *thisClass;
     };
+    struct PollWrite {
+        uint8_t *buf;
+        int size;
+        int offset;
+    };
     static void OnFileIO(uv_fs_t *req);
     int LoopRead();
+    bool SetupPoll();
+    static void OnPollIO(uv_poll_t *handle, int status, int events);
+    void PollRead();
+    void PollWriteQueue();
+    void UpdatePollEvents();
+    void FinishPoll(const bool fetal, const string &msg);
+    void ClosePoll();
 
     std::function<void()> callbackCloseFd;
     CmdResultCallback callbackFinish;
@@ -50,8 +67,22 @@ private:
     uv_fs_t reqClose;
     void *callerContext;
     bool workContinue;
+    bool readPaused;
+    bool readHeld;
     int fdIO;
     int refIO;
+    // poll mode, decided on the first StartWork or write
+    uv_poll_t pollIO;
+    list<PollWrite> listWrite;
+    uint8_t *readBuf;
+    int readMax;
+    int pollEvents;
+    bool pollChecked;
+    bool pollMode;
+    bool pollReading;
+    bool pollClosing;
+    bool finishReported;
+    bool closeFdIo;
 };
 }  // namespace Hdc
 
@@ -16,6 +16,8 @@
 #include "base.h"
 
 namespace Hdc {
+int HdcForwardBase::listenBacklog = FORWARD_LISTEN_BACKLOG_DEFAULT;
+
 HdcForwardBase::HdcForwardBase(HTaskInfo hTaskInfo)
     : HdcTaskBase(hTaskInfo)
 {
@@ -24,8 +26,16 @@ HdcForwardBase::HdcForwardBase(HTaskInfo hTaskInfo)
 HdcForwardBase::~HdcForwardBase()
 {
     WRITE_LOG(LOG_DEBUG, "~HdcForwardBase");
+    delete[] readBuf;
 };
 
+void HdcForwardBase::SetListenBacklog(const int backlog)
+{
+    if (backlog > 0) {
+        listenBacklog = backlog;
+    }
+}
+
 bool HdcForwardBase::ReadyForRelease()
 {
     if (!HdcTaskBase::ReadyForRelease()) {
@@ -43,33 +53,30 @@ void HdcForwardBase::StopTask()
     }
     // FREECONTEXT in the STOP is triggered by the other party sector, no longer notifying each other.
     mapCtxPoint.clear();
+    StopUdpHandles();
 };
 
-void HdcForwardBase::OnAccept(uv_stream_t *server, HCtxForward ctxClient, uv_stream_t *client)
+bool HdcForwardBase::ActiveSlave(HCtxForward ctxListen, HCtxForward ctxClient)
 {
-    HCtxForward ctxListen = (HCtxForward)server->data;
     char buf[BUF_SIZE_DEFAULT] = { 0 };
-    bool ret = false;
-    while (true) {
-        if (uv_accept(server, client)) {
-            break;
-        }
-        ctxClient->type = ctxListen->type;
-        ctxClient->remoteParamenters = ctxListen->remoteParamenters;
-        int maxSize = sizeof(buf) - FORWARD_PARAMENTER_BUFSIZE;
-        // clang-format off
-        if (snprintf_s(buf + FORWARD_PARAMENTER_BUFSIZE, maxSize, maxSize - 1, "%s",
-                       ctxClient->remoteParamenters.c_str()) < 0) {
-            break;
-        }
-        // clang-format on
-        // pre 8bytes preserve for param bits
-        SendToTask(ctxClient->id, CMD_FORWARD_ACTIVE_SLAVE, (uint8_t *)buf,
-                   strlen(buf + FORWARD_PARAMENTER_BUFSIZE) + 9);
-        ret = true;
-        break;
+    ctxClient->type = ctxListen->type;
+    ctxClient->remoteParamenters = ctxListen->remoteParamenters;
+    int maxSize = sizeof(buf) - FORWARD_PARAMENTER_BUFSIZE;
+    // clang-format off
+    if (snprintf_s(buf + FORWARD_PARAMENTER_BUFSIZE, maxSize, maxSize - 1, "%s",
+                   ctxClient->remoteParamenters.c_str()) < 0) {
+        return false;
     }
-    if (!ret) {
+    // clang-format on
+    // pre 8bytes preserve for param bits
+    SendToTask(ctxClient->id, CMD_FORWARD_ACTIVE_SLAVE, (uint8_t *)buf, strlen(buf + FORWARD_PARAMENTER_BUFSIZE) + 9);
+    return true;
+}
+
+void HdcForwardBase::OnAccept(uv_stream_t *server, HCtxForward ctxClient, uv_stream_t *client)
+{
+    HCtxForward ctxListen = (HCtxForward)server->data;
+    if (uv_accept(server, client) || !ActiveSlave(ctxListen, ctxClient)) {
         FreeContext(ctxClient, 0, false);
     }
 }
@@ -85,6 +92,12 @@ void HdcForwardBase::ListenCallback(uv_stream_t *server, const int status)
         thisClass->TaskFinish();
         return;
     }
+    // libuv calls back once per pending connection of a wakeup as long as each one is accepted, a transient
+    // failure such as running out of fds skips the connection and keeps the listener
+    if (status < 0) {
+        WRITE_LOG(LOG_WARN, "Forward accept failed:%d", status);
+        return;
+    }
     HCtxForward ctxClient = (HCtxForward)thisClass->MallocContext(true);
     if (!ctxClient) {
         return;
@@ -106,7 +119,10 @@ void *HdcForwardBase::MallocContext(bool masterSlave)
     if ((ctx = new ContextForward()) == nullptr) {
         return nullptr;
     }
-    ctx->id = Base::GetRuntimeMSec();
+    // ids only have to be unique inside this task: the master side picks them, the slave takes them over
+    do {
+        ctx->id = ++nextContextId;
+    } while (ctx->id == 0 || mapCtxPoint.count(ctx->id));
     ctx->masterSlave = masterSlave;
     ctx->thisClass = this;
     ctx->fdClass = nullptr;
@@ -188,6 +204,9 @@ void HdcForwardBase::FreeContext(HCtxForward ctxIn, const uint32_t id, bool bNot
             FreeJDWP(ctx);
             break;
         }
+        case FORWARD_UDP:
+            FreeUdpContext(ctx, funcHandleClose);
+            break;
         default:
             break;
     }
@@ -196,33 +215,26 @@ void HdcForwardBase::FreeContext(HCtxForward ctxIn, const uint32_t id, bool bNot
 
 bool HdcForwardBase::SendToTask(const uint32_t cid, const uint16_t command, uint8_t *bufPtr, const int bufSize)
 {
-    bool ret = false;
-    // usually MAX_SIZE_IOBUF*2 from HdcFileDescriptor maxIO
-    if (bufSize > Base::GetMaxBufSize() * 2) {
+    // FORWARD_READ_BUF_SIZE from socket reads, HdcFileDescriptor maxIO is smaller
+    if (bufSize > static_cast<int>(FORWARD_READ_BUF_SIZE)) {
         return false;
     }
-    auto newBuf = new uint8_t[bufSize + 4];
-    if (!newBuf) {
-        return false;
-    }
-    *(uint32_t *)(newBuf) = htonl(cid);
-    if (bufSize > 0 && bufPtr != nullptr && memcpy_s(newBuf + 4, bufSize, bufPtr, bufSize) != EOK) {
-        delete[] newBuf;
-        return false;
-    }
-    ret = SendToAnother(command, newBuf, bufSize + 4);
-    delete[] newBuf;
-    return ret;
+    // the cid rides in front of the data as the payload head, the data is copied only once into the packet
+    uint32_t cidBe = htonl(cid);
+    return SendToAnother(command, bufPtr, bufSize, reinterpret_cast<uint8_t *>(&cidBe), sizeof(cidBe));
 }
 
-// Forward flow is small and frequency is fast
+// Bulk streams want large reads, the task reads its contexts one at a time on its loop so one buffer serves all
 void HdcForwardBase::AllocForwardBuf(uv_handle_t *handle, size_t sizeSuggested, uv_buf_t *buf)
 {
-    const uint16_t size = 1492 - 256;  // For layer 3, the default MTU is 1492 bytes. reserve hdc header 256 bytes
-    buf->base = (char *)new char[size];
-    if (buf->base) {
-        buf->len = size - 1;
-    } else {
+    HdcForwardBase *thisClass = ((HCtxForward)handle->data)->thisClass;
+    if (thisClass->readBuf == nullptr) {
+        thisClass->readBuf = new(std::nothrow) uint8_t[FORWARD_READ_BUF_SIZE]();
+    }
+    // a null base makes libuv report UV_ENOBUFS to ReadForwardBuf, which frees the context
+    buf->base = (char *)thisClass->readBuf;
+    buf->len = thisClass->readBuf != nullptr ? FORWARD_READ_BUF_SIZE : 0;
+    if (thisClass->readBuf == nullptr) {
         WRITE_LOG(LOG_WARN, "AllocForwardBuf == null");
     }
 }
@@ -234,9 +246,90 @@ void HdcForwardBase::ReadForwardBuf(uv_stream_t *stream, ssize_t nread, const uv
         ctx->thisClass->FreeContext(ctx, 0, true);
         return;
     }
-    ctx->thisClass->SendToTask(ctx->id, CMD_FORWARD_DATA, (uint8_t *)buf->base, nread);
-    // clear
-    delete[] buf->base;
+    if (nread > 0) {
+        ctx->thisClass->SendToTask(ctx->id, CMD_FORWARD_DATA, (uint8_t *)buf->base, nread);
+    }
+    if (ctx->thisClass->SessionWritePaused()) {
+        ctx->thisClass->PauseForwardRead(ctx);
+    }
+}
+
+void HdcForwardBase::StopSourceRead(HCtxForward ctx)
+{
+    if (ctx->type == FORWARD_DEVICE) {
+        ctx->fdClass->PauseRead();
+    } else if (ctx->type == FORWARD_UDP) {
+        // a peer of the master listener shares its socket with the other peers, only its own datagrams are held
+        if (ctx->udpServer == nullptr) {
+            uv_udp_recv_stop(&ctx->udp);
+        }
+    } else if (ctx->type == FORWARD_TCP || ctx->type == FORWARD_JDWP) {
+        uv_read_stop((uv_stream_t *)&ctx->tcp);
+    } else {
+        uv_read_stop((uv_stream_t *)&ctx->pipe);
+    }
+}
+
+// the source is read again only when neither the session nor the peer holds it
+void HdcForwardBase::StartSourceRead(HCtxForward ctx)
+{
+    if (ctx->readPaused || ctx->remotePaused || ctx->finish) {
+        return;
+    }
+    if (ctx->type == FORWARD_DEVICE) {
+        ctx->fdClass->ResumeRead();
+    } else if (ctx->type == FORWARD_UDP) {
+        if (ctx->udpServer == nullptr) {
+            uv_udp_recv_start(&ctx->udp, AllocForwardBuf, ReadForwardUdp);
+        }
+        if (!ctx->udpBatch.empty()) {
+            // datagrams held while paused
+            vecUdpPending.push_back(ctx->id);
+            uv_check_start(&udpFlush, FlushUdpCallback);
+        }
+    } else if (ctx->type == FORWARD_TCP || ctx->type == FORWARD_JDWP) {
+        uv_read_start((uv_stream_t *)&ctx->tcp, AllocForwardBuf, ReadForwardBuf);
+    } else {
+        uv_read_start((uv_stream_t *)&ctx->pipe, AllocForwardBuf, ReadForwardBuf);
+    }
+}
+
+void HdcForwardBase::PauseForwardRead(HCtxForward ctx)
+{
+    if (ctx->readPaused || ctx->finish) {
+        return;
+    }
+    ctx->readPaused = true;
+    StopSourceRead(ctx);
+    WaitSessionWritable([this]() { ResumeForwardRead(); });
+}
+
+void HdcForwardBase::ResumeForwardRead()
+{
+    for (auto &item : mapCtxPoint) {
+        HCtxForward ctx = item.second;
+        if (!ctx->readPaused) {
+            continue;
+        }
+        ctx->readPaused = false;
+        StartSourceRead(ctx);
+    }
+}
+
+// End to end backpressure: when the local end drains slower than the peer reads its source, hold the peer
+// above the high watermark and release it below the low one. Peers without the commands ignore them.
+void HdcForwardBase::UpdatePeerPause(HCtxForward ctx)
+{
+    if (ctx->finish) {
+        return;
+    }
+    if (!ctx->peerPaused && ctx->writePending >= FORWARD_WRITE_HIGH_WATERMARK) {
+        ctx->peerPaused = true;
+        SendToTask(ctx->id, CMD_FORWARD_PAUSE, nullptr, 0);
+    } else if (ctx->peerPaused && ctx->writePending <= FORWARD_WRITE_LOW_WATERMARK) {
+        ctx->peerPaused = false;
+        SendToTask(ctx->id, CMD_FORWARD_RESUME, nullptr, 0);
+    }
 }
 
 void HdcForwardBase::ConnectTarget(uv_connect_t *connection, int status)
@@ -272,7 +365,7 @@ bool HdcForwardBase::CheckNodeInfo(const char *nodeInfo, string as[2])
     if (as[0].size() > BUF_SIZE_SMALL || as[1].size() > BUF_SIZE_SMALL) {
         return false;
     }
-    if (as[0] == "tcp") {
+    if (as[0] == "tcp" || as[0] == "udp") {
         int port = atoi(as[1].c_str());
         if (port <= 0 || port > MAX_IP_PORT) {
             return false;
@@ -324,6 +417,8 @@ bool HdcForwardBase::DetechForwardType(HCtxForward ctxPoint)
         ctxPoint->type = FORWARD_FILESYSTEM;
     } else if (sFType == "jdwp") {
         ctxPoint->type = FORWARD_JDWP;
+    } else if (sFType == "udp") {
+        ctxPoint->type = FORWARD_UDP;
     } else {
         return false;
     }
@@ -340,7 +435,7 @@ bool HdcForwardBase::SetupTCPPoint(HCtxForward ctxPoint)
     if (ctxPoint->masterSlave) {
         uv_ip4_addr("0.0.0.0", port, &addr);  // loop interface
         uv_tcp_bind(&ctxPoint->tcp, (const struct sockaddr *)&addr, 0);
-        if (uv_listen((uv_stream_t *)&ctxPoint->tcp, 4, ListenCallback)) {
+        if (uv_listen((uv_stream_t *)&ctxPoint->tcp, listenBacklog, ListenCallback)) {
             ctxPoint->lastError = "TCP Port listen failed at " + sNodeCfg;
             return false;
         }
@@ -368,7 +463,13 @@ bool HdcForwardBase::SetupDevicePoint(HCtxForward ctxPoint)
     }
     auto funcRead = [&](const void *a, uint8_t *b, const int c) -> bool {
         HCtxForward ctx = (HCtxForward)a;
-        return SendToTask(ctx->id, CMD_FORWARD_DATA, b, c);
+        if (!SendToTask(ctx->id, CMD_FORWARD_DATA, b, c)) {
+            return false;
+        }
+        if (SessionWritePaused()) {
+            PauseForwardRead(ctx);
+        }
+        return true;
     };
     auto funcFinish = [&](const void *a, const bool b, const string c) -> bool {
         HCtxForward ctx = (HCtxForward)a;
@@ -433,7 +534,7 @@ bool HdcForwardBase::SetupFilePoint(HCtxForward ctxPoint)
             ctxPoint->lastError = "Unix pipe bind failed";
             return false;
         }
-        if (uv_listen((uv_stream_t *)&ctxPoint->pipe, 4, ListenCallback)) {
+        if (uv_listen((uv_stream_t *)&ctxPoint->pipe, listenBacklog, ListenCallback)) {
             ctxPoint->lastError = "Unix pipe listen failed";
             return false;
         }
@@ -458,6 +559,283 @@ bool HdcForwardBase::SetupFilePoint(HCtxForward ctxPoint)
     return true;
 }
 
+// UDP forward: the master side binds the port and keeps one context per peer address, the slave side connects
+// one socket per context to the target. Datagrams are batched per context, each behind its 2-byte big-endian
+// length, and flushed when the batch is full or at the end of the loop turn.
+bool HdcForwardBase::SetupUDPPoint(HCtxForward ctxPoint)
+{
+    string &sNodeCfg = ctxPoint->localArgs[1];
+    int port = atoi(sNodeCfg.c_str());
+    ctxPoint->udp.data = ctxPoint;
+    uv_udp_init(loopTask, &ctxPoint->udp);
+    StartUdpHandles();
+    struct sockaddr_in addr;
+    if (ctxPoint->masterSlave) {
+        uv_ip4_addr("0.0.0.0", port, &addr);
+        if (uv_udp_bind(&ctxPoint->udp, (const struct sockaddr *)&addr, 0)
+            || uv_udp_recv_start(&ctxPoint->udp, AllocForwardBuf, ReadForwardUdp)) {
+            ctxPoint->lastError = "UDP Port bind failed at " + sNodeCfg;
+            return false;
+        }
+        uv_timer_start(&udpSweep, SweepUdpCallback, FORWARD_UDP_SWEEP_INTERVAL, FORWARD_UDP_SWEEP_INTERVAL);
+    } else {
+        uv_ip4_addr("127.0.0.1", port, &addr);  // loop interface
+        int ret = uv_udp_connect(&ctxPoint->udp, (const struct sockaddr *)&addr);
+        SetupPointContinue(ctxPoint, ret);
+        if (ret < 0) {
+            ctxPoint->lastError = "UDP connect failed at " + sNodeCfg;
+            return false;
+        }
+    }
+    return true;
+}
+
+void HdcForwardBase::StartUdpHandles()
+{
+    if (udpHandleReady) {
+        return;
+    }
+    uv_check_init(loopTask, &udpFlush);
+    uv_timer_init(loopTask, &udpSweep);
+    udpFlush.data = this;
+    udpSweep.data = this;
+    refCount += 2;  // 2: released by the close callbacks of both handles
+    udpHandleReady = true;
+}
+
+void HdcForwardBase::StopUdpHandles()
+{
+    if (!udpHandleReady) {
+        return;
+    }
+    udpHandleReady = false;
+    uv_close_cb funcHandleClose = [](uv_handle_t *handle) -> void {
+        HdcForwardBase *thisClass = (HdcForwardBase *)handle->data;
+        --thisClass->refCount;
+    };
+    uv_check_stop(&udpFlush);
+    uv_timer_stop(&udpSweep);
+    Base::TryCloseHandle((uv_handle_t *)&udpFlush, true, funcHandleClose);
+    Base::TryCloseHandle((uv_handle_t *)&udpSweep, true, funcHandleClose);
+}
+
+void HdcForwardBase::ReadForwardUdp(uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *addr,
+                                    unsigned flags)
+{
+    HCtxForward ctx = (HCtxForward)handle->data;
+    HdcForwardBase *thisClass = ctx->thisClass;
+    // no addr: the socket is drained or the error of a single datagram, the socket stays
+    if (nread < 0 || addr == nullptr || ctx->finish) {
+        return;
+    }
+    if (flags & UV_UDP_PARTIAL) {
+        WRITE_LOG(LOG_WARN, "Forward udp datagram over %u bytes, drop it", FORWARD_READ_BUF_SIZE);
+        return;
+    }
+    if (ctx->masterSlave) {
+        // the listener, answered by the peer only after CMD_FORWARD_CHECK_RESULT
+        if (!ctx->ready || addr->sa_family != AF_INET) {
+            return;
+        }
+        ctx = thisClass->QueryUdpPeer(ctx, (const struct sockaddr_in *)addr);
+        if (ctx == nullptr) {
+            return;
+        }
+    }
+    thisClass->AppendUdpDatagram(ctx, (uint8_t *)buf->base, nread);
+}
+
+HdcForwardBase::HCtxForward HdcForwardBase::QueryUdpPeer(HCtxForward ctxListen, const struct sockaddr_in *addr)
+{
+    string key((const char *)&addr->sin_port, sizeof(addr->sin_port));
+    key.append((const char *)&addr->sin_addr, sizeof(addr->sin_addr));
+    auto iter = mapUdpPeer.find(key);
+    if (iter != mapUdpPeer.end()) {
+        return iter->second;
+    }
+    HCtxForward ctx = (HCtxForward)MallocContext(true);
+    if (!ctx) {
+        return nullptr;
+    }
+    ctx->udpServer = ctxListen;
+    ctx->udpPeer = *addr;
+    ctx->udpKey = key;
+    ctx->lastActive = uv_now(loopTask);
+    mapUdpPeer[key] = ctx;
+    if (!ActiveSlave(ctxListen, ctx)) {
+        FreeContext(ctx, 0, false);
+        return nullptr;
+    }
+    return ctx;
+}
+
+void HdcForwardBase::AppendUdpDatagram(HCtxForward ctx, const uint8_t *data, const int size)
+{
+    constexpr int headSize = sizeof(uint16_t);
+    if (size + headSize > static_cast<int>(FORWARD_READ_BUF_SIZE)) {
+        WRITE_LOG(LOG_WARN, "Forward udp datagram size:%d too large, drop it", size);
+        return;
+    }
+    // a context not yet answered by the peer or paused holds at most one batch, udp may lose the rest
+    if (ctx->udpBatch.size() + headSize + size > FORWARD_READ_BUF_SIZE && !FlushUdpBatch(ctx)) {
+        return;
+    }
+    if (ctx->udpBatch.empty() && !ctx->readPaused && !ctx->remotePaused) {
+        vecUdpPending.push_back(ctx->id);
+        uv_check_start(&udpFlush, FlushUdpCallback);
+    }
+    uint16_t sizeBe = htons(size);
+    ctx->udpBatch.insert(ctx->udpBatch.end(), (uint8_t *)&sizeBe, (uint8_t *)&sizeBe + headSize);
+    ctx->udpBatch.insert(ctx->udpBatch.end(), data, data + size);
+    ctx->lastActive = uv_now(loopTask);
+}
+
+bool HdcForwardBase::FlushUdpBatch(HCtxForward ctx)
+{
+    if (!ctx->ready || ctx->finish || ctx->readPaused || ctx->remotePaused) {
+        return false;
+    }
+    if (ctx->udpBatch.empty()) {
+        return true;
+    }
+    bool ret = SendToTask(ctx->id, CMD_FORWARD_DATA, ctx->udpBatch.data(), ctx->udpBatch.size());
+    ctx->udpBatch.clear();
+    if (SessionWritePaused()) {
+        PauseForwardRead(ctx);
+    }
+    return ret;
+}
+
+void HdcForwardBase::FlushUdpCallback(uv_check_t *handle)
+{
+    HdcForwardBase *thisClass = (HdcForwardBase *)handle->data;
+    vector<uint32_t> pending;
+    pending.swap(thisClass->vecUdpPending);
+    for (uint32_t id : pending) {
+        HCtxForward ctx = (HCtxForward)thisClass->AdminContext(OP_QUERY, id, nullptr);
+        if (ctx == nullptr || ctx->finish || ctx->udpBatch.empty()) {
+            continue;
+        }
+        if (ctx->readPaused || ctx->remotePaused) {
+            continue;  // StartSourceRead queues it again
+        }
+        if (!ctx->ready) {
+            thisClass->vecUdpPending.push_back(id);  // waits for CMD_FORWARD_ACTIVE_MASTER
+            continue;
+        }
+        thisClass->FlushUdpBatch(ctx);
+    }
+    if (thisClass->vecUdpPending.empty()) {
+        uv_check_stop(handle);
+    }
+}
+
+void HdcForwardBase::SweepUdpCallback(uv_timer_t *handle)
+{
+    HdcForwardBase *thisClass = (HdcForwardBase *)handle->data;
+    uint64_t now = uv_now(thisClass->loopTask);
+    vector<HCtxForward> idle;
+    for (auto &item : thisClass->mapUdpPeer) {
+        if (now - item.second->lastActive >= FORWARD_UDP_IDLE_TIMEOUT) {
+            idle.push_back(item.second);
+        }
+    }
+    for (HCtxForward ctx : idle) {
+        WRITE_LOG(LOG_DEBUG, "Forward udp peer id:%u idle, release it", ctx->id);
+        thisClass->FreeContext(ctx, 0, true);
+    }
+}
+
+// a datagram the socket can not take now is copied and queued, beyond the high watermark it is dropped
+int HdcForwardBase::SendUdpBuf(HCtxForward ctx, uint8_t *bufPtr, const int size)
+{
+    constexpr int headSize = sizeof(uint16_t);
+    HCtxForward ctxSocket = ctx->udpServer != nullptr ? ctx->udpServer : ctx;
+    if (ctxSocket->finish) {
+        return -1;
+    }
+    const struct sockaddr *addr = ctx->udpServer != nullptr ? (const struct sockaddr *)&ctx->udpPeer : nullptr;
+    ctx->lastActive = uv_now(loopTask);
+    int offset = 0;
+    while (offset + headSize <= size) {
+        int len = (bufPtr[offset] << 8) | bufPtr[offset + 1];  // 8: high byte of the big-endian length
+        offset += headSize;
+        if (offset + len > size) {
+            WRITE_LOG(LOG_WARN, "SendUdpBuf bad datagram length:%d", len);
+            return -1;
+        }
+        uint8_t *datagram = bufPtr + offset;
+        offset += len;
+        uv_buf_t bufUv = uv_buf_init((char *)datagram, len);
+        int ret = uv_udp_try_send(&ctxSocket->udp, &bufUv, 1, addr);
+        if (ret != UV_EAGAIN || ctx->writePending >= FORWARD_WRITE_HIGH_WATERMARK) {
+            continue;  // sent, or failed and lost like on any udp path
+        }
+        auto ctxIO = new(std::nothrow) ContextForwardUdpIO();
+        auto req = new(std::nothrow) uv_udp_send_t();
+        uint8_t *pDynBuf = new(std::nothrow) uint8_t[len + 1];  // 1: a zero length datagram still gets a buffer
+        if (ctxIO == nullptr || req == nullptr || pDynBuf == nullptr
+            || (len > 0 && memcpy_s(pDynBuf, len, datagram, len) != EOK)) {
+            delete ctxIO;
+            delete req;
+            delete[] pDynBuf;
+            continue;
+        }
+        ctxIO->thisClass = this;
+        ctxIO->id = ctx->id;
+        ctxIO->bufIO = pDynBuf;
+        ctxIO->size = len;
+        req->data = ctxIO;
+        bufUv = uv_buf_init((char *)pDynBuf, len);
+        if (uv_udp_send(req, &ctxSocket->udp, &bufUv, 1, addr, SendCallbackUdp) < 0) {
+            delete ctxIO;
+            delete req;
+            delete[] pDynBuf;
+            continue;
+        }
+        ctx->writePending += len;
+        ++refCount;
+    }
+    return size;
+}
+
+void HdcForwardBase::SendCallbackUdp(uv_udp_send_t *req, int status)
+{
+    ContextForwardUdpIO *ctxIO = (ContextForwardUdpIO *)req->data;
+    HdcForwardBase *thisClass = ctxIO->thisClass;
+    HCtxForward ctx = (HCtxForward)thisClass->AdminContext(OP_QUERY, ctxIO->id, nullptr);
+    if (ctx != nullptr) {
+        ctx->writePending -= ctxIO->size;
+    }
+    --thisClass->refCount;
+    delete[] ctxIO->bufIO;
+    delete ctxIO;
+    delete req;
+}
+
+void HdcForwardBase::FreeUdpContext(HCtxForward ctx, uv_close_cb funcHandleClose)
+{
+    if (ctx->udpServer != nullptr) {
+        // a peer of the listener owns no socket
+        mapUdpPeer.erase(ctx->udpKey);
+        FreeContextCallBack(ctx);
+        return;
+    }
+    if (ctx->masterSlave) {
+        // the peers can not be answered without the listener socket
+        vector<HCtxForward> peers;
+        for (auto &item : mapUdpPeer) {
+            if (item.second->udpServer == ctx) {
+                peers.push_back(item.second);
+            }
+        }
+        for (HCtxForward peer : peers) {
+            FreeContext(peer, 0, true);
+        }
+    }
+    Base::TryCloseHandle((uv_handle_t *)&ctx->udp, true, funcHandleClose);
+}
+
 bool HdcForwardBase::SetupPoint(HCtxForward ctxPoint)
 {
     bool ret = true;
@@ -470,6 +848,11 @@ bool HdcForwardBase::SetupPoint(HCtxForward ctxPoint)
                 ret = false;
             };
             break;
+        case FORWARD_UDP:
+            if (!SetupUDPPoint(ctxPoint)) {
+                ret = false;
+            };
+            break;
 #ifndef _WIN32
         case FORWARD_DEVICE:
             if (!SetupDevicePoint(ctxPoint)) {
@@ -534,6 +917,11 @@ bool HdcForwardBase::BeginForward(const string &command, string &sError)
         if (!CheckNodeInfo(argv[1], ctxPoint->remoteArgs)) {
             break;
         }
+        // datagrams keep their boundaries only between two udp ends
+        if ((ctxPoint->localArgs[0] == "udp") != (ctxPoint->remoteArgs[0] == "udp")) {
+            ctxPoint->lastError = "UDP can only be forwarded to UDP";
+            break;
+        }
         ctxPoint->remoteParamenters = argv[1];
         if (!SetupPoint(ctxPoint)) {
             break;
@@ -616,6 +1004,12 @@ bool HdcForwardBase::DoForwardBegin(HCtxForward ctx)
             ctx->fdClass->StartWork();
             break;
         }
+        case FORWARD_UDP:
+            // the master side reads through its listener, datagrams held until now go with the next flush
+            if (ctx->udpServer == nullptr) {
+                uv_udp_recv_start(&ctx->udp, AllocForwardBuf, ReadForwardUdp);
+            }
+            break;
         default:
             break;
     }
@@ -653,9 +1047,12 @@ void HdcForwardBase::SendCallbackForwardBuf(uv_write_t *req, int status)
 {
     ContextForwardIO *ctxIO = (ContextForwardIO *)req->data;
     HCtxForward ctx = (HCtxForward)ctxIO->ctxForward;
+    ctx->writePending -= ctxIO->size;
     if (status < 0 && !ctx->finish) {
         WRITE_LOG(LOG_DEBUG, "SendCallbackForwardBuf ctx->type:%d, status:%d finish", ctx->type, status);
         ctx->thisClass->FreeContext(ctx, 0, true);
+    } else {
+        ctx->thisClass->UpdatePeerPause(ctx);
     }
     delete[] ctxIO->bufIO;
     delete ctxIO;
@@ -672,6 +1069,9 @@ int HdcForwardBase::SendForwardBuf(HCtxForward ctx, uint8_t *bufPtr, const int s
         WRITE_LOG(LOG_WARN, "SendForwardBuf failed size:%d", size);
         return -1;
     }
+    if (FORWARD_UDP == ctx->type) {
+        return SendUdpBuf(ctx, bufPtr, size);
+    }
     auto pDynBuf = new uint8_t[size];
     if (!pDynBuf) {
         return -1;
@@ -687,6 +1087,7 @@ int HdcForwardBase::SendForwardBuf(HCtxForward ctx, uint8_t *bufPtr, const int s
         }
         ctxIO->ctxForward = ctx;
         ctxIO->bufIO = pDynBuf;
+        ctxIO->size = size;
         if (FORWARD_TCP == ctx->type || FORWARD_JDWP == ctx->type) {
             nRet = Base::SendToStreamEx((uv_stream_t *)&ctx->tcp, pDynBuf, size, nullptr,
                                         (void *)SendCallbackForwardBuf, (void *)ctxIO);
@@ -695,6 +1096,11 @@ int HdcForwardBase::SendForwardBuf(HCtxForward ctx, uint8_t *bufPtr, const int s
             nRet = Base::SendToStreamEx((uv_stream_t *)&ctx->pipe, pDynBuf, size, nullptr,
                                         (void *)SendCallbackForwardBuf, (void *)ctxIO);
         }
+        if (nRet > 0) {
+            // counted off in SendCallbackForwardBuf
+            ctx->writePending += size;
+            UpdatePeerPause(ctx);
+        }
     }
     return nRet;
 }
@@ -751,6 +1157,16 @@ bool HdcForwardBase::ForwardCommandDispatch(const uint16_t command, uint8_t *pay
             FreeContext(ctx, 0, false);
             break;
         }
+        case CMD_FORWARD_PAUSE: {
+            ctx->remotePaused = true;
+            StopSourceRead(ctx);
+            break;
+        }
+        case CMD_FORWARD_RESUME: {
+            ctx->remotePaused = false;
+            StartSourceRead(ctx);
+            break;
+        }
         default:
             ret = false;
             break;
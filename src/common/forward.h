@@ -25,6 +25,7 @@ public:
     bool BeginForward(const string &command, string &sError);
     void StopTask();
     bool ReadyForRelease();
+    static void SetListenBacklog(const int backlog);  // set at startup, before any forward task runs
 
 protected:
     enum FORWARD_TYPE {
@@ -34,6 +35,7 @@ protected:
         FORWARD_ABSTRACT,
         FORWARD_RESERVED,
         FORWARD_FILESYSTEM,
+        FORWARD_UDP,
     };
     struct ContextForward {
         FORWARD_TYPE type;
@@ -41,10 +43,21 @@ protected:
         bool checkPoint;
         bool ready;
         bool finish;
+        bool readPaused;    // held by session write backpressure
+        bool remotePaused;  // held by the peer, its side of the forward can not write fast enough
+        bool peerPaused;    // we asked the peer to hold its source
+        uint64_t writePending;  // bytes queued toward the local end and not yet written
         int fd;
         uint32_t id;
         uv_tcp_t tcp;
         uv_pipe_t pipe;
+        uv_udp_t udp;
+        // udp master side: one context per peer address, all answered through the socket of udpServer
+        struct ContextForward *udpServer;
+        struct sockaddr_in udpPeer;
+        string udpKey;
+        vector<uint8_t> udpBatch;  // datagrams read but not yet sent, each behind its 2-byte length
+        uint64_t lastActive;       // uv_now of the last datagram of a udp peer either way
         HdcFileDescriptor *fdClass;
         HdcForwardBase *thisClass;
         string path;
@@ -57,6 +70,14 @@ protected:
     struct ContextForwardIO {
         HCtxForward ctxForward;
         uint8_t *bufIO;
+        int size;
+    };
+    // the context is looked up again on completion, a udp peer may be gone while the listener socket still sends
+    struct ContextForwardUdpIO {
+        HdcForwardBase *thisClass;
+        uint32_t id;
+        uint8_t *bufIO;
+        int size;
     };
 
     virtual bool SetupJdwpPoint(HCtxForward ctxPoint)
@@ -72,6 +93,11 @@ private:
     static void AllocForwardBuf(uv_handle_t *handle, size_t sizeSuggested, uv_buf_t *buf);
     static void SendCallbackForwardBuf(uv_write_t *req, int status);
     static void OnFdRead(uv_fs_t *req);
+    static void ReadForwardUdp(uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *addr,
+                               unsigned flags);
+    static void SendCallbackUdp(uv_udp_send_t *req, int status);
+    static void FlushUdpCallback(uv_check_t *handle);
+    static void SweepUdpCallback(uv_timer_t *handle);
 
     bool SetupPoint(HCtxForward ctxPoint);
     void *MallocContext(bool masterSlave);
@@ -91,11 +117,34 @@ private:
     bool SetupTCPPoint(HCtxForward ctxPoint);
     bool SetupDevicePoint(HCtxForward ctxPoint);
     bool SetupFilePoint(HCtxForward ctxPoint);
+    bool SetupUDPPoint(HCtxForward ctxPoint);
+    bool ActiveSlave(HCtxForward ctxListen, HCtxForward ctxClient);
+    HCtxForward QueryUdpPeer(HCtxForward ctxListen, const struct sockaddr_in *addr);
+    void AppendUdpDatagram(HCtxForward ctx, const uint8_t *data, const int size);
+    bool FlushUdpBatch(HCtxForward ctx);
+    int SendUdpBuf(HCtxForward ctx, uint8_t *bufPtr, const int size);
+    void FreeUdpContext(HCtxForward ctx, uv_close_cb funcHandleClose);
+    void StartUdpHandles();
+    void StopUdpHandles();
     bool ForwardCommandDispatch(const uint16_t command, uint8_t *payload, const int payloadSize);
     bool CommandForwardCheckResult(HCtxForward ctx, uint8_t *payload);
     bool LocalAbstractConnect(uv_pipe_t *pipe, string &sNodeCfg);
+    void PauseForwardRead(HCtxForward ctx);
+    void ResumeForwardRead();
+    void StopSourceRead(HCtxForward ctx);
+    void StartSourceRead(HCtxForward ctx);
+    void UpdatePeerPause(HCtxForward ctx);
 
+    static int listenBacklog;
     map<uint32_t, HCtxForward> mapCtxPoint;
+    uint32_t nextContextId = 0;
+    // FORWARD_READ_BUF_SIZE, shared by the socket reads of all contexts since each read is packed before the next
+    uint8_t *readBuf = nullptr;
+    map<string, HCtxForward> mapUdpPeer;  // udp master side, peer address to its context
+    vector<uint32_t> vecUdpPending;       // ids of udp contexts with a batch to flush
+    uv_check_t udpFlush;                  // flushes the batches read in one loop turn
+    uv_timer_t udpSweep;                  // releases idle udp peers
+    bool udpHandleReady = false;
     string taskCommand;
     const uint8_t FORWARD_PARAMENTER_BUFSIZE = 8;
     const string FILESYSTEM_SOCKET_PREFIX = "/tmp/";
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "latency.h"
+
+namespace Hdc {
+HdcLatency &HdcLatency::Get()
+{
+    static HdcLatency instance;  // static storage, retired totals start zeroed
+    return instance;
+}
+
+HdcLatency::ShardHolder::~ShardHolder()
+{
+    if (shard != nullptr) {
+        shard->orphan = true;
+    }
+}
+
+HdcLatency::Shard *HdcLatency::GetThreadShard()
+{
+    thread_local ShardHolder holder;
+    if (holder.shard != nullptr) {
+        return holder.shard.get();
+    }
+    std::shared_ptr<Shard> shard = std::make_shared<Shard>();  // value initialized, all counters zero
+    {
+        std::lock_guard<std::mutex> lock(mutexShards);
+        vecShards.push_back(shard);
+    }
+    holder.shard = shard;
+    return shard.get();
+}
+
+uint32_t HdcLatency::BucketIndex(uint64_t valueNs)
+{
+    valueNs = std::min(valueNs, static_cast<uint64_t>((1ULL << (MAX_VALUE_BITS + 1)) - 1));
+    if (valueNs < SUB_BUCKET_COUNT) {
+        return valueNs;
+    }
+    uint32_t msb = 63 - __builtin_clzll(valueNs);
+    uint32_t shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + ((valueNs >> shift) & (SUB_BUCKET_COUNT - 1));
+}
+
+// highest value that falls in the bucket
+uint64_t HdcLatency::BucketValue(uint32_t index)
+{
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t sub = index % SUB_BUCKET_COUNT;
+    return ((SUB_BUCKET_COUNT + sub + 1) << shift) - 1;
+}
+
+void HdcLatency::Record(const uint8_t point, const uint64_t beginNs)
+{
+    if (beginNs == 0 || point >= LAT_POINT_COUNT) {
+        return;
+    }
+    uint64_t now = uv_hrtime();
+    uint64_t valueNs = now > beginNs ? now - beginNs : 0;
+    Shard *shard = Get().GetThreadShard();
+    shard->buckets[point][BucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    // single writer, a concurrent reset may lose one max which is fine
+    if (valueNs > shard->maxNs[point].load(std::memory_order_relaxed)) {
+        shard->maxNs[point].store(valueNs, std::memory_order_relaxed);
+    }
+}
+
+string HdcLatency::FormatPoint(const char *name, const Summary &summary)
+{
+    constexpr double nsPerUs = 1000.0;
+    constexpr double ranks[] = { 0.5, 0.9, 0.99, 0.999 };
+    constexpr size_t rankCount = sizeof(ranks) / sizeof(ranks[0]);
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        count += summary.buckets[i];
+    }
+    double values[rankCount] = { 0 };
+    uint64_t seen = 0;
+    size_t rank = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT && rank < rankCount && count > 0; ++i) {
+        seen += summary.buckets[i];
+        while (rank < rankCount && seen >= static_cast<uint64_t>(ranks[rank] * count + 0.5) && seen > 0) {
+            values[rank++] = std::min(BucketValue(i), summary.maxNs) / nsPerUs;
+        }
+    }
+    return Base::StringFormat("latency %-15s count:%" PRIu64 " p50:%.1fus p90:%.1fus p99:%.1fus p999:%.1fus "
+                              "max:%.1fus\n", name, count, values[0], values[1], values[2], values[3],
+                              summary.maxNs / nsPerUs);
+}
+
+// one line per point, reset clears what has been dumped
+string HdcLatency::Dump(bool reset)
+{
+    static const char *names[LAT_POINT_COUNT] = { "client_echo", "session_write", "usb_transfer",
+                                                  "task_first_data" };
+    HdcLatency &instance = Get();
+    vector<Summary> total(LAT_POINT_COUNT);
+    std::lock_guard<std::mutex> lock(instance.mutexShards);
+    for (auto it = instance.vecShards.begin(); it != instance.vecShards.end();) {
+        Shard *shard = it->get();
+        bool orphan = shard->orphan;
+        for (int point = 0; point < LAT_POINT_COUNT; ++point) {
+            // the owner thread is gone, keep its samples in the retired totals added below
+            Summary &target = orphan ? instance.retired[point] : total[point];
+            for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+                target.buckets[i] += reset ? shard->buckets[point][i].exchange(0, std::memory_order_relaxed) :
+                                             shard->buckets[point][i].load(std::memory_order_relaxed);
+            }
+            uint64_t maxNs = reset ? shard->maxNs[point].exchange(0, std::memory_order_relaxed) :
+                                     shard->maxNs[point].load(std::memory_order_relaxed);
+            target.maxNs = std::max(target.maxNs, maxNs);
+        }
+        it = orphan ? instance.vecShards.erase(it) : it + 1;
+    }
+    string ret;
+    for (int point = 0; point < LAT_POINT_COUNT; ++point) {
+        Summary &retired = instance.retired[point];
+        for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+            total[point].buckets[i] += retired.buckets[i];
+        }
+        total[point].maxNs = std::max(total[point].maxNs, retired.maxNs);
+        ret += FormatPoint(names[point], total[point]);
+    }
+    if (reset) {
+        (void)memset_s(instance.retired, sizeof(instance.retired), 0, sizeof(instance.retired));
+    }
+    return ret;
+}
+}  // namespace Hdc
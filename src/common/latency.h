@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_LATENCY_H
+#define HDC_LATENCY_H
+#include "common.h"
+
+namespace Hdc {
+// Always-on latency histograms for the points of HdcLatencyPoint, dumped by "hdc stat".
+// Buckets are log-linear like HDR histograms: 16 buckets per power of two, so a value is kept within 1/16.
+// Each thread records into its own shard without locks, the dumper sums all shards; the shard of an exited
+// thread is folded into the retired totals on the next dump.
+class HdcLatency {
+public:
+    static void Record(const uint8_t point, const uint64_t beginNs);  // beginNs 0 means not started, ignored
+    static string Dump(bool reset);
+
+private:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_VALUE_BITS = 40;  // about 18 minutes in ns, larger values fall in the last bucket
+    static constexpr uint32_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+    struct Shard {
+        std::atomic<uint64_t> buckets[LAT_POINT_COUNT][BUCKET_COUNT];
+        std::atomic<uint64_t> maxNs[LAT_POINT_COUNT];
+        std::atomic<bool> orphan;
+    };
+    struct ShardHolder {
+        std::shared_ptr<Shard> shard;
+        ~ShardHolder();
+    };
+    struct Summary {
+        uint64_t buckets[BUCKET_COUNT];
+        uint64_t maxNs;
+    };
+    static HdcLatency &Get();
+    static uint32_t BucketIndex(uint64_t valueNs);
+    static uint64_t BucketValue(uint32_t index);
+    static string FormatPoint(const char *name, const Summary &summary);
+    Shard *GetThreadShard();
+
+    std::mutex mutexShards;
+    vector<std::shared_ptr<Shard>> vecShards;
+    Summary retired[LAT_POINT_COUNT];  // exited threads, protected by mutexShards
+};
+}  // namespace Hdc
+
+#endif  // HDC_LATENCY_H
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "loopback.h"
+
+namespace Hdc {
+std::mutex HdcLoopback::mutexListener;
+map<string, HdcLoopback *> HdcLoopback::mapListener;
+
+HdcLoopback::HdcLoopback(const bool serverOrDaemonIn, void *ptrMainBase)
+{
+    serverOrDaemon = serverOrDaemonIn;
+    clsMainBase = ptrMainBase;
+    asyncAccept = {};
+}
+
+HdcLoopback::~HdcLoopback()
+{
+}
+
+bool HdcLoopback::IsLoopbackKey(const string &connectKey)
+{
+    return connectKey.size() > LOOPBACK_KEY_PREFIX.size() && connectKey.find(LOOPBACK_KEY_PREFIX) == 0;
+}
+
+// daemon side, run in main thread
+bool HdcLoopback::Listen(const string &name)
+{
+    HdcSessionBase *ptrMainBase = (HdcSessionBase *)clsMainBase;
+    std::lock_guard<std::mutex> lock(mutexListener);
+    if (!listenName.empty() || mapListener.count(name)) {
+        WRITE_LOG(LOG_WARN, "Loopback %s already listened", name.c_str());
+        return false;
+    }
+    if (uv_async_init(&ptrMainBase->loopMain, &asyncAccept, AcceptLink) < 0) {
+        return false;
+    }
+    asyncAccept.data = this;
+    listenName = name;
+    mapListener[name] = this;
+    WRITE_LOG(LOG_DEBUG, "Loopback listen on %s", name.c_str());
+    return true;
+}
+
+void HdcLoopback::Stop()
+{
+    if (listenName.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutexListener);
+        mapListener.erase(listenName);
+    }
+    listenName = "";
+    {
+        std::lock_guard<std::mutex> lock(mutexAccept);
+        for (auto &link : listAccept) {
+            CloseLink(link, -1);
+        }
+        listAccept.clear();
+    }
+    Base::TryCloseHandle((uv_handle_t *)&asyncAccept);
+}
+
+// server side, run in main thread
+HSession HdcLoopback::ConnectDaemon(const string &connectKey)
+{
+    if (!IsLoopbackKey(connectKey)) {
+        return nullptr;
+    }
+    string name = connectKey.substr(LOOPBACK_KEY_PREFIX.size());
+    std::shared_ptr<HdcLoopbackLink> link = std::make_shared<HdcLoopbackLink>();
+    {
+        std::lock_guard<std::mutex> lock(mutexListener);
+        auto iter = mapListener.find(name);
+        if (iter == mapListener.end() || !iter->second->QueueAccept(link)) {
+            WRITE_LOG(LOG_WARN, "No loopback daemon listen on %s", name.c_str());
+            return nullptr;
+        }
+    }
+    HSession hSession = PrepareNewSession(link, connectKey);
+    if (hSession == nullptr) {
+        CloseLink(link, -1);
+    }
+    return hSession;
+}
+
+bool HdcLoopback::QueueAccept(const std::shared_ptr<HdcLoopbackLink> &link)
+{
+    std::lock_guard<std::mutex> lock(mutexAccept);
+    listAccept.push_back(link);
+    return uv_async_send(&asyncAccept) == 0;
+}
+
+void HdcLoopback::AcceptLink(uv_async_t *handle)
+{
+    HdcLoopback *thisClass = (HdcLoopback *)handle->data;
+    list<std::shared_ptr<HdcLoopbackLink>> listLink;
+    {
+        std::lock_guard<std::mutex> lock(thisClass->mutexAccept);
+        listLink.swap(thisClass->listAccept);
+    }
+    for (auto &link : listLink) {
+        if (thisClass->PrepareNewSession(link, "") == nullptr) {
+            CloseLink(link, -1);
+        }
+    }
+}
+
+// both ends run a session work thread like USB, the session starts once its child loop is up
+HSession HdcLoopback::PrepareNewSession(const std::shared_ptr<HdcLoopbackLink> &link, const string &connectKey)
+{
+    HdcSessionBase *ptrMainBase = (HdcSessionBase *)clsMainBase;
+    HSession hSession = ptrMainBase->MallocSession(serverOrDaemon, CONN_LOOPBACK, this);
+    if (!hSession) {
+        WRITE_LOG(LOG_FATAL, "Loopback MallocSession failed");
+        return nullptr;
+    }
+    hSession->connectKey = connectKey;
+    hSession->hLoopback->link = link;
+    hSession->hLoopback->side = serverOrDaemon ? STREAM_MAIN : STREAM_WORK;
+    hSession->hLoopback->asyncRead.data = hSession;
+    if (Base::StartWorkThread(&ptrMainBase->loopMain, ptrMainBase->SessionWorkThread, Base::FinishWorkThread,
+                              hSession) < 0) {
+        ptrMainBase->FreeSession(hSession->sessionId);
+        return nullptr;
+    }
+    auto funcNewSessionUp = [](uv_timer_t *handle) -> void {
+        HSession hSession = reinterpret_cast<HSession>(handle->data);
+        HdcSessionBase *ptrMainBase = reinterpret_cast<HdcSessionBase *>(hSession->classInstance);
+        if (hSession->childLoop.active_handles == 0) {
+            return;
+        }
+        if (!hSession->isDead) {
+            auto ctrl = ptrMainBase->BuildCtrlString(SP_START_SESSION, 0, nullptr, 0);
+            Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
+        }
+        Base::TryCloseHandle(reinterpret_cast<uv_handle_t *>(handle), Base::CloseTimerCallback);
+    };
+    Base::TimerUvTask(&ptrMainBase->loopMain, hSession, funcNewSessionUp);
+    return hSession;
+}
+
+// run in work thread
+bool HdcLoopback::ReadyForWorkThread(HSession hSession)
+{
+    HLoopback hLoopback = hSession->hLoopback;
+    if (hLoopback == nullptr || hLoopback->link == nullptr) {
+        return false;
+    }
+    if (uv_async_init(hSession->GetWorkLoop(), &hLoopback->asyncRead, ReadLink) < 0) {
+        return false;
+    }
+    hLoopback->asyncRead.data = hSession;
+    HdcLoopbackLink *link = hLoopback->link.get();
+    std::lock_guard<std::mutex> lock(link->mutexLink);
+    link->wakeup[hLoopback->side] = &hLoopback->asyncRead;
+    // peer may have sent the handshake before this end was ready
+    if (link->closed || !link->inbox[hLoopback->side].empty()) {
+        uv_async_send(&hLoopback->asyncRead);
+    }
+    return true;
+}
+
+void HdcLoopback::ReadLink(uv_async_t *handle)
+{
+    HSession hSession = (HSession)handle->data;
+    HdcSessionBase *ptrMainBase = (HdcSessionBase *)hSession->classInstance;
+    HLoopback hLoopback = hSession->hLoopback;
+    HdcLoopbackLink *link = hLoopback->link.get();
+    string data;
+    bool closed = false;
+    {
+        std::lock_guard<std::mutex> lock(link->mutexLink);
+        data.swap(link->inbox[hLoopback->side]);
+        closed = link->closed;
+    }
+    // copied into ioBuf piecewise, the same path as a socket read
+    size_t offset = 0;
+    while (offset < data.size() && !hSession->isDead) {
+        Base::ReallocBuf(&hSession->ioBuf, &hSession->bufSize, HDC_SOCKETPAIR_SIZE);
+        int room = hSession->bufSize - hSession->availTailIndex;
+        int size = static_cast<int>(std::min(static_cast<size_t>(std::max(room, 0)), data.size() - offset));
+        if (size <= 0
+            || memcpy_s(hSession->ioBuf + hSession->availTailIndex, room, data.data() + offset, size) != EOK) {
+            closed = true;
+            break;
+        }
+        offset += size;
+        if (ptrMainBase->FetchIOBuf(hSession, hSession->ioBuf, size) < 0) {
+            closed = true;
+            break;
+        }
+    }
+    if (closed) {
+        ptrMainBase->FreeSession(hSession->sessionId);
+    }
+}
+
+int HdcLoopback::SendLoopbackData(HSession hSession, uint8_t *data, const int length)
+{
+    HLoopback hLoopback = hSession->hLoopback;
+    if (hLoopback == nullptr || hLoopback->link == nullptr || length <= 0) {
+        return ERR_GENERIC;
+    }
+    HdcLoopbackLink *link = hLoopback->link.get();
+    uint8_t peer = hLoopback->side == STREAM_MAIN ? STREAM_WORK : STREAM_MAIN;
+    std::lock_guard<std::mutex> lock(link->mutexLink);
+    if (link->closed) {
+        return ERR_IO_FAIL;
+    }
+    link->inbox[peer].append(reinterpret_cast<char *>(data), length);
+    if (link->wakeup[peer] != nullptr) {
+        uv_async_send(link->wakeup[peer]);
+    }
+    return length;
+}
+
+// the other end reads what is left, then frees its session
+void HdcLoopback::CloseLink(const std::shared_ptr<HdcLoopbackLink> &link, const int detachSide)
+{
+    if (link == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(link->mutexLink);
+    link->closed = true;
+    for (int i = STREAM_MAIN; i <= STREAM_WORK; ++i) {
+        if (i == detachSide) {
+            link->wakeup[i] = nullptr;
+        } else if (link->wakeup[i] != nullptr) {
+            uv_async_send(link->wakeup[i]);
+        }
+    }
+}
+
+// run in work thread when session stops, the close callback is always called
+void HdcLoopback::StopReadWork(HSession hSession, uv_close_cb closeCallback)
+{
+    HLoopback hLoopback = hSession->hLoopback;
+    CloseLink(hLoopback->link, hLoopback->side);
+    Base::TryCloseHandle((uv_handle_t *)&hLoopback->asyncRead, true, closeCallback);
+}
+
+// run in main thread after the work thread exited
+void HdcLoopback::StopSession(HSession hSession)
+{
+    HLoopback hLoopback = hSession->hLoopback;
+    if (hLoopback == nullptr) {
+        return;
+    }
+    CloseLink(hLoopback->link, hLoopback->side);
+    delete hLoopback;
+    hSession->hLoopback = nullptr;
+}
+}  // namespace Hdc
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_LOOPBACK_H
+#define HDC_LOOPBACK_H
+#include "common.h"
+
+namespace Hdc {
+// Byte pipe between a server session and a daemon session living in the same process. Sending appends to the inbox
+// of the other end and wakes its work loop, which feeds the bytes to FetchIOBuf like any other transport.
+struct HdcLoopbackLink {
+    std::mutex mutexLink;
+    string inbox[2];                               // indexed by HdcLoopbackEnd::side of the reader
+    uv_async_t *wakeup[2] = { nullptr, nullptr };  // set while the work loop of that end runs
+    bool closed = false;
+};
+
+// Transport used by tests and benchmarks to run the whole session and task stack without USB or TCP.
+// A daemon listens by name, the server connects with the key LOOPBACK_KEY_PREFIX + name.
+class HdcLoopback {
+public:
+    HdcLoopback(const bool serverOrDaemonIn, void *ptrMainBase);
+    virtual ~HdcLoopback();
+    static bool IsLoopbackKey(const string &connectKey);
+    bool Listen(const string &name);
+    HSession ConnectDaemon(const string &connectKey);
+    void Stop();
+    bool ReadyForWorkThread(HSession hSession);
+    int SendLoopbackData(HSession hSession, uint8_t *data, const int length);
+    void StopReadWork(HSession hSession, uv_close_cb closeCallback);
+    void StopSession(HSession hSession);
+
+private:
+    bool QueueAccept(const std::shared_ptr<HdcLoopbackLink> &link);
+    HSession PrepareNewSession(const std::shared_ptr<HdcLoopbackLink> &link, const string &connectKey);
+    static void AcceptLink(uv_async_t *handle);
+    static void ReadLink(uv_async_t *handle);
+    static void CloseLink(const std::shared_ptr<HdcLoopbackLink> &link, const int detachSide);
+
+    static std::mutex mutexListener;
+    static map<string, HdcLoopback *> mapListener;
+    void *clsMainBase;
+    bool serverOrDaemon;
+    string listenName;
+    uv_async_t asyncAccept;
+    std::mutex mutexAccept;
+    list<std::shared_ptr<HdcLoopbackLink>> listAccept;
+};
+}  // namespace Hdc
+
+#endif  // HDC_LOOPBACK_H
@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "send_queue.h"
+
+namespace Hdc {
+HdcSendQueue::HdcSendQueue(HSession hSessionIn, uint32_t localWindowIn)
+{
+    hSession = hSessionIn;
+    localWindow = localWindowIn;
+    peerWindow = 0;
+    peerFlowControl = false;
+    announced = false;
+    pumping = false;
+    queuedBytes = 0;
+    remoteBytes = 0;
+    writePaused = false;
+    batchBuf = nullptr;
+    batchLen = 0;
+    batchEcho = false;
+    batchStart = 0;
+    batchEnqueueNs = 0;
+    for (int i = 0; i < PRIORITY_COUNT; ++i) {
+        roundLeft[i] = weight[i];
+    }
+    // created on the session work thread
+    checkReady = uv_check_init(hSession->GetWorkLoop(), &checkFlush) == 0;
+    checkFlush.data = this;
+}
+
+HdcSendQueue::~HdcSendQueue()
+{
+    for (auto &item : mapChannel) {
+        for (auto &packet : item.second.packets) {
+            delete[] packet.buf;
+        }
+    }
+    mapChannel.clear();
+    for (auto &item : listRemote) {
+        delete[] item.packet.buf;
+    }
+    listRemote.clear();
+    listActive.clear();
+    listWaiter.clear();
+    delete[] batchBuf;
+}
+
+// session is stopping on work thread, the check handle must leave the loop before this class is freed
+void HdcSendQueue::Stop()
+{
+    if (!checkReady) {
+        return;
+    }
+    checkReady = false;
+    uv_check_stop(&checkFlush);
+    uv_close((uv_handle_t *)&checkFlush, nullptr);
+}
+
+uint8_t HdcSendQueue::GetPriority(const uint32_t channelId, const uint16_t commandFlag)
+{
+    if (channelId == 0) {
+        return PRIORITY_CONTROL;
+    }
+    switch (commandFlag) {
+        case CMD_SHELL_INIT:
+        case CMD_SHELL_DATA:
+        case CMD_BENCH_PING:
+        case CMD_BENCH_PONG:
+            return PRIORITY_INTERACTIVE;
+        case CMD_FILE_DATA:
+        case CMD_APP_DATA:
+        case CMD_FORWARD_DATA:
+        case CMD_UNITY_BUGREPORT_DATA:
+        case CMD_BENCH_SINK:
+        case CMD_BENCH_SOURCE:
+        case CMD_KERNEL_ECHO_RAW:
+            return PRIORITY_BULK;
+        default:
+            return PRIORITY_CONTROL;
+    }
+}
+
+bool HdcSendQueue::IsFlowControlled(const uint32_t channelId, const uint16_t commandFlag)
+{
+    if (channelId == 0) {
+        return false;
+    }
+    return commandFlag == CMD_SHELL_DATA || GetPriority(channelId, commandFlag) == PRIORITY_BULK;
+}
+
+HdcSendQueue::ChannelQueue *HdcSendQueue::GetChannel(const uint32_t channelId)
+{
+    auto iter = mapChannel.find(channelId);
+    if (iter != mapChannel.end()) {
+        return &iter->second;
+    }
+    ChannelQueue &chq = mapChannel[channelId];
+    chq.credit = peerWindow;
+    return &chq;
+}
+
+bool HdcSendQueue::Sendable(const uint32_t channelId, const ChannelQueue &chq)
+{
+    const SendPacket &packet = chq.packets.front();
+    if (!peerFlowControl || !IsFlowControlled(channelId, packet.commandFlag)) {
+        return true;
+    }
+    // a packet larger than the whole window goes out once nothing else is outstanding
+    return chq.credit >= packet.dataSize || chq.credit >= static_cast<int64_t>(peerWindow);
+}
+
+// USB and UART sends are synchronous, only TCP writes stay queued in libuv
+uint64_t HdcSendQueue::InflightBytes()
+{
+    if (hSession->connType != CONN_TCP || hSession->hChildWorkTCP.loop == nullptr) {
+        return 0;
+    }
+    return uv_stream_get_write_queue_size((uv_stream_t *)&hSession->hChildWorkTCP);
+}
+
+bool HdcSendQueue::TransportHasRoom()
+{
+    return InflightBytes() < SEND_INFLIGHT_MAX;
+}
+
+int HdcSendQueue::SendHead(const uint32_t channelId)
+{
+    ChannelQueue &chq = mapChannel[channelId];
+    SendPacket packet = chq.packets.front();
+    chq.packets.pop_front();
+    queuedBytes -= packet.bufLen;
+    if (peerFlowControl && IsFlowControlled(channelId, packet.commandFlag)) {
+        chq.credit -= packet.dataSize;
+    }
+    if (chq.packets.empty()) {
+        if (packet.commandFlag == CMD_KERNEL_CHANNEL_CLOSE) {
+            mapChannel.erase(channelId);
+            mapRecvConsumed.erase(channelId);
+        }
+    } else {
+        listActive.push_back(channelId);
+    }
+    return Emit(packet.buf, packet.bufLen, packet.echo, packet.enqueueNs);
+}
+
+int HdcSendQueue::Emit(uint8_t *buf, const int bufLen, bool echo, const uint64_t enqueueNs)
+{
+    if (bufLen >= SEND_COALESCE_PACKET_MAX || !checkReady) {
+        FlushBatch();
+        return Transmit(buf, bufLen, echo, enqueueNs);
+    }
+    if (batchLen + bufLen > SEND_COALESCE_BATCH_MAX || (batchLen > 0 && batchEcho != echo)) {
+        FlushBatch();
+    }
+    if (batchBuf == nullptr) {
+        batchBuf = new(std::nothrow) uint8_t[SEND_COALESCE_BATCH_MAX];
+        if (batchBuf == nullptr) {
+            return Transmit(buf, bufLen, echo, enqueueNs);
+        }
+        batchStart = uv_hrtime();
+        batchEnqueueNs = enqueueNs;
+        batchEcho = echo;
+        uv_check_start(&checkFlush, CheckFlush);
+    }
+    if (memcpy_s(batchBuf + batchLen, SEND_COALESCE_BATCH_MAX - batchLen, buf, bufLen) != EOK) {
+        FlushBatch();
+        return Transmit(buf, bufLen, echo, enqueueNs);
+    }
+    batchLen += bufLen;
+    delete[] buf;
+    if (uv_hrtime() - batchStart >= SEND_COALESCE_LATENCY_NS) {
+        FlushBatch();
+    }
+    return bufLen;
+}
+
+void HdcSendQueue::FlushBatch()
+{
+    if (batchBuf == nullptr) {
+        return;
+    }
+    uint8_t *buf = batchBuf;
+    int len = batchLen;
+    batchBuf = nullptr;
+    batchLen = 0;
+    uv_check_stop(&checkFlush);
+    if (len == 0) {
+        delete[] buf;
+        return;
+    }
+    // packets are a byte stream for every transport, the peer splits them again in FetchIOBuf
+    Transmit(buf, len, batchEcho, batchEnqueueNs);
+}
+
+// end of loop turn, everything gathered since the last poll goes out as one write
+void HdcSendQueue::CheckFlush(uv_check_t *handle)
+{
+    HdcSendQueue *thisClass = (HdcSendQueue *)handle->data;
+    thisClass->FlushBatch();
+}
+
+// a TCP write that finishes later calls OnWriteFinish from FinishWriteSessionTCP
+int HdcSendQueue::Transmit(uint8_t *buf, const int bufLen, bool echo, const uint64_t enqueueNs)
+{
+    HdcSessionBase *thisClass = (HdcSessionBase *)hSession->classInstance;
+    int ret = thisClass->SendByProtocol(hSession, buf, bufLen, echo);
+    HdcLatency::Record(LAT_SESSION_WRITE, enqueueNs);
+    return ret;
+}
+
+void HdcSendQueue::Pump()
+{
+    if (pumping) {
+        return;
+    }
+    pumping = true;
+    while (!listActive.empty() && !hSession->isDead && TransportHasRoom()) {
+        bool sent = false;
+        for (int prio = 0; prio < PRIORITY_COUNT && !sent; ++prio) {
+            if (roundLeft[prio] == 0) {
+                continue;
+            }
+            for (auto iter = listActive.begin(); iter != listActive.end(); ++iter) {
+                uint32_t channelId = *iter;
+                ChannelQueue &chq = mapChannel[channelId];
+                if (GetPriority(channelId, chq.packets.front().commandFlag) != prio || !Sendable(channelId, chq)) {
+                    continue;
+                }
+                listActive.erase(iter);
+                --roundLeft[prio];
+                SendHead(channelId);
+                sent = true;
+                break;
+            }
+        }
+        if (sent) {
+            continue;
+        }
+        bool fullRound = true;
+        for (int i = 0; i < PRIORITY_COUNT; ++i) {
+            fullRound = fullRound && roundLeft[i] == weight[i];
+            roundLeft[i] = weight[i];
+        }
+        if (fullRound) {
+            break;  // everything left is waiting for credit
+        }
+    }
+    pumping = false;
+}
+
+int HdcSendQueue::Push(const uint32_t channelId, const uint16_t commandFlag, uint8_t *buf, const int bufLen,
+                       const int dataSize, bool echo)
+{
+    ChannelQueue *chq = GetChannel(channelId);
+    chq->packets.push_back({ buf, bufLen, dataSize, commandFlag, echo, uv_hrtime() });
+    queuedBytes += bufLen;
+    if (chq->packets.size() == 1 && listActive.empty() && !pumping && TransportHasRoom() &&
+        Sendable(channelId, *chq)) {
+        // nothing to schedule against, send now and keep the caller's error code
+        int ret = SendHead(channelId);
+        UpdateWatermark();
+        return ret;
+    }
+    if (chq->packets.size() == 1) {
+        listActive.push_back(channelId);
+    }
+    Pump();
+    UpdateWatermark();
+    return bufLen;
+}
+
+// Any thread but the work thread, the packet is queued and sent in order by DrainRemote on the work thread
+int HdcSendQueue::PushRemote(const uint32_t channelId, const uint16_t commandFlag, uint8_t *buf, const int bufLen,
+                             const int dataSize, bool echo)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutexRemote);
+        wake = listRemote.empty();
+        listRemote.push_back({ channelId, { buf, bufLen, dataSize, commandFlag, echo, uv_hrtime() } });
+    }
+    remoteBytes += bufLen;
+    if (wake) {
+        HdcSessionBase *thisClass = (HdcSessionBase *)hSession->classInstance;
+        auto ctrl = thisClass->BuildCtrlString(SP_FLUSH_SEND_QUEUE, 0, nullptr, 0);
+        if (thisClass->SendCtrlToWorkThread(hSession, ctrl) < 0) {
+            WRITE_LOG(LOG_DEBUG, "Session %u send queue wakeup failed", hSession->sessionId);
+        }
+    }
+    return bufLen;
+}
+
+void HdcSendQueue::DrainRemote()
+{
+    list<RemotePacket> packets;
+    {
+        std::lock_guard<std::mutex> lock(mutexRemote);
+        packets.swap(listRemote);
+    }
+    for (auto &item : packets) {
+        SendPacket &packet = item.packet;
+        remoteBytes -= packet.bufLen;
+        if (hSession->isDead) {
+            delete[] packet.buf;
+            continue;
+        }
+        Push(item.channelId, packet.commandFlag, packet.buf, packet.bufLen, packet.dataSize, packet.echo);
+    }
+}
+
+void HdcSendQueue::OnWriteFinish()
+{
+    Pump();
+    UpdateWatermark();
+}
+
+void HdcSendQueue::UpdateWatermark()
+{
+    uint64_t pending = queuedBytes + remoteBytes + InflightBytes();
+    hSession->stat.bytesQueued.store(pending, std::memory_order_relaxed);
+    if (!writePaused && pending >= SESSION_WRITE_HIGH_WATERMARK) {
+        WRITE_LOG(LOG_DEBUG, "Session %u write paused, pending:%" PRIu64 "", hSession->sessionId, pending);
+        writePaused = true;
+    } else if (writePaused && pending <= SESSION_WRITE_LOW_WATERMARK) {
+        WRITE_LOG(LOG_DEBUG, "Session %u write resumed, pending:%" PRIu64 "", hSession->sessionId, pending);
+        writePaused = false;
+        WakeWaiters();
+    }
+}
+
+// resume is called once on the session work thread, it must check its owner state again.
+// One owner may wait more than once, e.g. a file task per transfer context, every resume is kept.
+void HdcSendQueue::WaitWritable(void *key, std::function<void()> resume)
+{
+    listWaiter.push_back(std::make_pair(key, resume));
+}
+
+void HdcSendQueue::CancelWaitWritable(void *key)
+{
+    listWaiter.remove_if([key](const std::pair<void *, std::function<void()>> &item) { return item.first == key; });
+}
+
+void HdcSendQueue::WakeWaiters()
+{
+    list<std::pair<void *, std::function<void()>>> waiters;
+    waiters.swap(listWaiter);
+    for (auto &item : waiters) {
+        item.second();
+    }
+}
+
+// peer has closed the channel, its data would be dropped there anyway
+void HdcSendQueue::DropChannelData(const uint32_t channelId)
+{
+    auto iter = mapChannel.find(channelId);
+    if (iter == mapChannel.end()) {
+        return;
+    }
+    list<SendPacket> &packets = iter->second.packets;
+    for (auto it = packets.begin(); it != packets.end();) {
+        if (!IsFlowControlled(channelId, it->commandFlag)) {
+            ++it;
+            continue;
+        }
+        queuedBytes -= it->bufLen;
+        delete[] it->buf;
+        it = packets.erase(it);
+    }
+    if (packets.empty()) {
+        listActive.remove(channelId);
+        mapChannel.erase(iter);
+    }
+}
+
+void HdcSendQueue::SendWindowUpdate(const uint32_t channelId, const uint32_t bytes)
+{
+    uint32_t payload[2] = { htonl(channelId), htonl(bytes) };
+    HdcSessionBase *thisClass = (HdcSessionBase *)hSession->classInstance;
+    thisClass->SendToSession(hSession, 0, CMD_KERNEL_WINDOW_UPDATE, (uint8_t *)payload, sizeof(payload));
+}
+
+void HdcSendQueue::OnWindowUpdate(const uint32_t channelId, const uint32_t bytes)
+{
+    auto iter = mapChannel.find(channelId);
+    if (iter == mapChannel.end()) {
+        return;  // channel finished, new one starts with full credit
+    }
+    ChannelQueue &chq = iter->second;
+    // sends from non-work thread bypass credit, never grow beyond the window
+    chq.credit = std::min(chq.credit + bytes, static_cast<int64_t>(peerWindow));
+}
+
+void HdcSendQueue::Announce()
+{
+    announced = true;
+    SendWindowUpdate(0, localWindow);
+}
+
+// return true if the command is consumed by send queue
+bool HdcSendQueue::OnRecvCommand(const uint32_t channelId, const uint16_t commandFlag, const uint8_t *payload,
+                                 const int payloadSize)
+{
+    if (commandFlag == CMD_KERNEL_WINDOW_UPDATE) {
+        uint32_t value[2] = { 0 };
+        if (payloadSize < static_cast<int>(sizeof(value)) ||
+            memcpy_s(value, sizeof(value), payload, sizeof(value)) != EOK) {
+            return true;
+        }
+        uint32_t target = ntohl(value[0]);
+        uint32_t bytes = ntohl(value[1]);
+        if (target == 0) {
+            // peer understands window update, start credit from its announced window
+            WRITE_LOG(LOG_DEBUG, "Session %u peer window %u", hSession->sessionId, bytes);
+            peerWindow = bytes;
+            peerFlowControl = true;
+            for (auto &item : mapChannel) {
+                item.second.credit = peerWindow;
+            }
+            if (!announced) {
+                Announce();
+            }
+        } else {
+            OnWindowUpdate(target, bytes);
+        }
+        Pump();
+        UpdateWatermark();
+        return true;
+    }
+    if (commandFlag == CMD_KERNEL_CHANNEL_CLOSE) {
+        DropChannelData(channelId);
+        mapRecvConsumed.erase(channelId);
+        UpdateWatermark();
+    }
+    return false;
+}
+
+// the payload has been dispatched to its task, the peer may send that much more on the channel
+void HdcSendQueue::OnRecvConsumed(const uint32_t channelId, const uint16_t commandFlag, const int payloadSize)
+{
+    if (!announced || !peerFlowControl || payloadSize <= 0 || !IsFlowControlled(channelId, commandFlag)) {
+        return;
+    }
+    uint32_t &consumed = mapRecvConsumed[channelId];
+    consumed += payloadSize;
+    if (consumed >= localWindow / 2) {
+        uint32_t bytes = consumed;
+        consumed = 0;
+        SendWindowUpdate(channelId, bytes);
+    }
+}
+}  // namespace Hdc
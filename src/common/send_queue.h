@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_SEND_QUEUE_H
+#define HDC_SEND_QUEUE_H
+#include "common.h"
+
+namespace Hdc {
+// Per-session send scheduler, only touched from the session work thread except PushRemote.
+// Packets keep FIFO order inside a channel; channels are served by weighted round robin
+// (interactive > control > bulk), and data commands consume the credit announced by peer.
+// Credit comes back once a packet has been dispatched to its task, not once the task has written it out, so the
+// window only bounds the bytes in flight on the transport. What a slow task keeps queued on the receiving side is
+// bounded only where the task asks the peer to pause, as forward does with CMD_FORWARD_PAUSE.
+// Pending bytes above the high watermark pause readers until they drop under the low watermark.
+// Small packets produced in one loop turn are flushed together from a uv_check hook.
+class HdcSendQueue {
+public:
+    enum SendPriority {
+        PRIORITY_INTERACTIVE,
+        PRIORITY_CONTROL,
+        PRIORITY_BULK,
+        PRIORITY_COUNT,
+    };
+    HdcSendQueue(HSession hSessionIn, uint32_t localWindowIn);
+    virtual ~HdcSendQueue();
+    int Push(const uint32_t channelId, const uint16_t commandFlag, uint8_t *buf, const int bufLen,
+             const int dataSize, bool echo);
+    int PushRemote(const uint32_t channelId, const uint16_t commandFlag, uint8_t *buf, const int bufLen,
+                   const int dataSize, bool echo);
+    void DrainRemote();
+    void OnWriteFinish();
+    bool OnRecvCommand(const uint32_t channelId, const uint16_t commandFlag, const uint8_t *payload,
+                       const int payloadSize);
+    void OnRecvConsumed(const uint32_t channelId, const uint16_t commandFlag, const int payloadSize);
+    void Announce();
+    bool WritePaused()
+    {
+        return writePaused;
+    }
+    void WaitWritable(void *key, std::function<void()> resume);
+    void CancelWaitWritable(void *key);
+    void WakeWaiters();
+    void Stop();
+    static uint8_t GetPriority(const uint32_t channelId, const uint16_t commandFlag);
+    static bool IsFlowControlled(const uint32_t channelId, const uint16_t commandFlag);
+
+private:
+    struct SendPacket {
+        uint8_t *buf;
+        int bufLen;
+        int dataSize;
+        uint16_t commandFlag;
+        bool echo;
+        uint64_t enqueueNs;
+    };
+    struct RemotePacket {
+        uint32_t channelId;
+        SendPacket packet;
+    };
+    struct ChannelQueue {
+        list<SendPacket> packets;
+        int64_t credit;
+    };
+    // packets per round for each SendPriority
+    const uint8_t weight[PRIORITY_COUNT] = { 8, 4, 1 };
+
+    ChannelQueue *GetChannel(const uint32_t channelId);
+    bool Sendable(const uint32_t channelId, const ChannelQueue &chq);
+    uint64_t InflightBytes();
+    bool TransportHasRoom();
+    int SendHead(const uint32_t channelId);
+    void Pump();
+    int Emit(uint8_t *buf, const int bufLen, bool echo, const uint64_t enqueueNs);
+    int Transmit(uint8_t *buf, const int bufLen, bool echo, const uint64_t enqueueNs);
+    void FlushBatch();
+    static void CheckFlush(uv_check_t *handle);
+    void SendWindowUpdate(const uint32_t channelId, const uint32_t bytes);
+    void OnWindowUpdate(const uint32_t channelId, const uint32_t bytes);
+    void DropChannelData(const uint32_t channelId);
+    void UpdateWatermark();
+
+    HSession hSession;
+    map<uint32_t, ChannelQueue> mapChannel;  // send side only, erased once CMD_KERNEL_CHANNEL_CLOSE is sent
+    map<uint32_t, uint32_t> mapRecvConsumed;  // bytes consumed since the last window update, by channel
+    std::mutex mutexRemote;
+    list<RemotePacket> listRemote;  // sent from main thread, kept in order with the work thread sends
+    std::atomic<uint64_t> remoteBytes;  // in listRemote, part of the pending bytes
+    list<uint32_t> listActive;  // channels with pending packets, round robin order
+    uint8_t roundLeft[PRIORITY_COUNT];
+    uint32_t localWindow;
+    uint32_t peerWindow;
+    bool peerFlowControl;
+    bool announced;
+    bool pumping;
+    uint64_t queuedBytes;  // held by this queue, not yet handed to transport
+    bool writePaused;
+    list<std::pair<void *, std::function<void()>>> listWaiter;  // readers paused by high watermark, by owner
+    uv_check_t checkFlush;
+    bool checkReady;
+    uint8_t *batchBuf;
+    int batchLen;
+    bool batchEcho;  // echo and other packets are never coalesced together
+    uint64_t batchStart;
+    uint64_t batchEnqueueNs;  // first packet put into the batch
+};
+}  // namespace Hdc
+
+#endif  // HDC_SEND_QUEUE_H
@@ -17,6 +17,7 @@
 #include "common.h"
 #include "serial_struct_define.h"
 #include "transfer.h"
+#include "bench.h"
 
 namespace Hdc {
 namespace SerialStruct {
@@ -63,6 +64,17 @@ namespace SerialStruct {
         }
     };
 
+    template<> struct Descriptor<Hdc::HdcBench::BenchConfig> {
+        static auto type()
+        {
+            return Message(Field<fieldOne, &Hdc::HdcBench::BenchConfig::mode>("mode"),
+                           Field<fieldTwo, &Hdc::HdcBench::BenchConfig::packetSize>("packetSize"),
+                           Field<fieldThree, &Hdc::HdcBench::BenchConfig::concurrency>("concurrency"),
+                           Field<fieldFour, &Hdc::HdcBench::BenchConfig::count>("count"),
+                           Field<fieldFive, &Hdc::HdcBench::BenchConfig::duration>("duration"));
+        }
+    };
+
     template<> struct Descriptor<Hdc::HdcSessionBase::SessionHandShake> {
         static auto type()
         {
@@ -27,7 +27,8 @@ HdcSessionBase::HdcSessionBase(bool serverOrDaemonIn, size_t uvThreadSize)
         uvThreadSize = SIZE_THREAD_POOL_MAX;
     }
     threadPoolCount = uvThreadSize;
-    WRITE_LOG(LOG_INFO, "set UV_THREADPOOL_SIZE:%zu", threadPoolCount);
+    WRITE_LOG(LOG_INFO, "set UV_THREADPOOL_SIZE:%zu session work threads:%zu", threadPoolCount,
+              Base::GetWorkThreadLimit());
     string uvThreadEnv("UV_THREADPOOL_SIZE");
     string uvThreadVal = std::to_string(threadPoolCount);
 #ifdef _WIN32
@@ -41,7 +42,9 @@ HdcSessionBase::HdcSessionBase(bool serverOrDaemonIn, size_t uvThreadSize)
     WRITE_LOG(LOG_DEBUG, "loopMain init");
     uv_rwlock_init(&mainAsync);
     uv_async_init(&loopMain, &asyncMainLoop, MainAsyncCallback);
-    uv_rwlock_init(&lockMapSession);
+    for (auto &shard : sessionShards) {
+        uv_rwlock_init(&shard.lock);
+    }
     serverOrDaemon = serverOrDaemonIn;
     ctxUSB = nullptr;
     wantRestart = false;
@@ -58,11 +61,14 @@ HdcSessionBase::HdcSessionBase(bool serverOrDaemonIn, size_t uvThreadSize)
 
 HdcSessionBase::~HdcSessionBase()
 {
+    StopLoopShards();
     Base::TryCloseHandle((uv_handle_t *)&asyncMainLoop);
     uv_loop_close(&loopMain);
     // clear base
     uv_rwlock_destroy(&mainAsync);
-    uv_rwlock_destroy(&lockMapSession);
+    for (auto &shard : sessionShards) {
+        uv_rwlock_destroy(&shard.lock);
+    }
 #ifdef HDC_HOST
     if (serverOrDaemon and ctxUSB != nullptr) {
         libusb_exit((libusb_context *)ctxUSB);
@@ -149,18 +155,91 @@ void HdcSessionBase::ClearOwnTasks(HSession hSession, const uint32_t channelIDIn
         BeginRemoveTask(hTask);
         ++iter;
     }
+    if (hSession->sendQueue != nullptr && uv_thread_self() == hSession->hWorkChildThread) {
+        // readers held by write backpressure must run again to notice the stop
+        hSession->sendQueue->WakeWaiters();
+    }
 }
 
 void HdcSessionBase::ClearSessions()
 {
-    // no need to lock mapSession
-    // broadcast free singal
-    for (auto v : mapSession) {
-        HSession hSession = (HSession)v.second;
+    // collect first, FreeSession will query the shard again
+    vector<uint32_t> aliveSessions;
+    EnumSessions([&aliveSessions](HSession hSession) -> bool {
         if (!hSession->isDead) {
-            FreeSession(hSession->sessionId);
+            aliveSessions.push_back(hSession->sessionId);
+        }
+        return false;
+    });
+    // broadcast free singal
+    for (auto sessionId : aliveSessions) {
+        FreeSession(sessionId);
+    }
+}
+
+// Walk all shards with their read lock held, stop when func returns true
+void HdcSessionBase::EnumSessions(const std::function<bool(HSession)> &func)
+{
+    for (auto &shard : sessionShards) {
+        bool stop = false;
+        uv_rwlock_rdlock(&shard.lock);
+        for (auto &kv : shard.mapSession) {
+            if ((stop = func(kv.second))) {
+                break;
+            }
         }
+        uv_rwlock_rdunlock(&shard.lock);
+        if (stop) {
+            break;
+        }
+    }
+}
+
+string HdcSessionBase::ConnTypeName(const uint8_t connType)
+{
+    switch (connType) {
+        case CONN_USB:
+            return "USB";
+        case CONN_TCP:
+            return "TCP";
+        case CONN_SERIAL:
+            return "UART";
+        case CONN_BT:
+            return "BT";
+        case CONN_LOOPBACK:
+            return "LOOPBACK";
+        default:
+            return "UNKNOW";
+    }
+}
+
+// tasks are owned by the session work thread, only list them when called there
+string HdcSessionBase::DumpSessionStat(HSession hSession, bool withTasks)
+{
+    string ret = Base::StringFormat("session %u %s %s %s\n", hSession->sessionId,
+                                    ConnTypeName(hSession->connType).c_str(),
+                                    hSession->connectKey.empty() ? "-" : hSession->connectKey.c_str(),
+                                    hSession->stat.ToString().c_str());
+    if (!withTasks || hSession->mapTask == nullptr) {
+        return ret;
+    }
+    for (auto &kv : *hSession->mapTask) {
+        HTaskInfo hTask = kv.second;
+        ret += Base::StringFormat("  task channel:%u type:%u in:%" PRIu64 "/%" PRIu64 "B out:%" PRIu64 "/%" PRIu64
+                                  "B\n", hTask->channelId, hTask->taskType, hTask->packetsIn, hTask->bytesIn,
+                                  hTask->packetsOut, hTask->bytesOut);
     }
+    return ret;
+}
+
+string HdcSessionBase::DumpAllSessionStat()
+{
+    string ret;
+    EnumSessions([this, &ret](HSession hSession) -> bool {
+        ret += DumpSessionStat(hSession, false);
+        return false;
+    });
+    return ret;
 }
 
 void HdcSessionBase::ReMainLoopForInstanceClear()
@@ -181,17 +260,13 @@ void HdcSessionBase::ReMainLoopForInstanceClear()
 #ifdef HDC_SUPPORT_UART
 void HdcSessionBase::EnumUARTDeviceRegister(UartKickoutZombie kickOut)
 {
-    uv_rwlock_rdlock(&lockMapSession);
-    map<uint32_t, HSession>::iterator i;
-    for (i = mapSession.begin(); i != mapSession.end(); ++i) {
-        HSession hs = i->second;
+    EnumSessions([&kickOut](HSession hs) -> bool {
         if ((hs->connType != CONN_SERIAL) or (hs->hUART == nullptr)) {
-            continue;
+            return false;
         }
         kickOut(hs);
-        break;
-    }
-    uv_rwlock_rdunlock(&lockMapSession);
+        return true;
+    });
 }
 #endif
 
@@ -200,22 +275,16 @@ void HdcSessionBase::EnumUSBDeviceRegister(void (*pCallBack)(HSession hSession))
     if (!pCallBack) {
         return;
     }
-    uv_rwlock_rdlock(&lockMapSession);
-    map<uint32_t, HSession>::iterator i;
-    for (i = mapSession.begin(); i != mapSession.end(); ++i) {
-        HSession hs = i->second;
+    EnumSessions([pCallBack](HSession hs) -> bool {
         if (hs->connType != CONN_USB) {
-            continue;
+            return false;
         }
         if (hs->hUSB == nullptr) {
-            continue;
-        }
-        if (pCallBack) {
-            pCallBack(hs);
+            return false;
         }
-        break;
-    }
-    uv_rwlock_rdunlock(&lockMapSession);
+        pCallBack(hs);
+        return true;
+    });
 }
 
 // The PC side gives the device information, determines if the USB device is registered
@@ -225,9 +294,6 @@ HSession HdcSessionBase::QueryUSBDeviceRegister(void *pDev, uint8_t busIDIn, uin
 #ifdef HDC_HOST
     libusb_device *dev = (libusb_device *)pDev;
     HSession hResult = nullptr;
-    if (!mapSession.size()) {
-        return nullptr;
-    }
     uint8_t busId = 0;
     uint8_t devId = 0;
     if (pDev) {
@@ -237,23 +303,19 @@ HSession HdcSessionBase::QueryUSBDeviceRegister(void *pDev, uint8_t busIDIn, uin
         busId = busIDIn;
         devId = devIDIn;
     }
-    uv_rwlock_rdlock(&lockMapSession);
-    map<uint32_t, HSession>::iterator i;
-    for (i = mapSession.begin(); i != mapSession.end(); ++i) {
-        HSession hs = i->second;
+    EnumSessions([&hResult, busId, devId](HSession hs) -> bool {
         if (hs->connType == CONN_USB) {
-            continue;
+            return false;
         }
         if (hs->hUSB == nullptr) {
-            continue;
+            return false;
         }
         if (hs->hUSB->devId != devId || hs->hUSB->busId != busId) {
-            continue;
+            return false;
         }
         hResult = hs;
-        break;
-    }
-    uv_rwlock_rdunlock(&lockMapSession);
+        return true;
+    });
     return hResult;
 #else
     return nullptr;
@@ -272,6 +334,13 @@ void HdcSessionBase::AsyncMainLoopTask(uv_idle_t *handle)
         case ASYNC_STOP_MAINLOOP:
             uv_stop(&thisClass->loopMain);
             break;
+        case ASYNC_SESSION_CTRL: {
+            HSession hSession = thisClass->AdminSession(OP_QUERY, param->sid, nullptr);
+            if (hSession && param->data) {
+                thisClass->DispatchSessionThreadCommand(nullptr, hSession, (uint8_t *)param->data, param->dataSize);
+            }
+            break;
+        }
         default:
             break;
     }
@@ -330,6 +399,7 @@ void HdcSessionBase::PushAsyncMessage(const uint32_t sessionId, const uint8_t me
 
 void HdcSessionBase::WorkerPendding()
 {
+    HdcTrace::NameThread("main");
     uv_run(&loopMain, UV_RUN_DEFAULT);
     ClearInstanceResource();
 }
@@ -366,6 +436,13 @@ int HdcSessionBase::MallocSessionByConnectType(HSession hSession)
             break;
         }
 #endif // HDC_SUPPORT_UART
+        case CONN_LOOPBACK: {
+            hSession->hLoopback = new(std::nothrow) HdcLoopbackEnd();
+            if (!hSession->hLoopback) {
+                ret = -1;
+            }
+            break;
+        }
         default:
             ret = -1;
             break;
@@ -417,11 +494,54 @@ HSession HdcSessionBase::MallocSession(bool serverOrDaemon, const ConnType connT
         hSession = nullptr;
         return nullptr;
     }
-    uv_loop_init(&hSession->childLoop);
     hSession->uvHandleRef = 0;
     // pullup child
     WRITE_LOG(LOG_DEBUG, "HdcSessionBase NewSession, sessionId:%u, connType:%d.",
               hSession->sessionId, hSession->connType);
+    if (connType == CONN_TCP) {
+        // no socketpair bridge for TCP, M:N mode pins the session to the least loaded shard
+        LoopShard *shard = nullptr;
+        if (!loopShards.empty()) {
+            shard = *std::min_element(loopShards.begin(), loopShards.end(),
+                [](const LoopShard *a, const LoopShard *b) { return a->sessionCount < b->sessionCount; });
+        } else if ((shard = new(std::nothrow) LoopShard()) != nullptr) {
+            shard->sessionCount = 0;
+            shard->stopping = false;
+            shard->closing = false;
+            shard->privateLoop = true;
+            shard->running = false;
+            shard->thisClass = this;
+            uv_loop_init(&shard->loop);
+            uv_async_init(&shard->loop, &shard->asyncCtrl, LoopShardAsyncCallback);
+            shard->asyncCtrl.data = shard;
+        } else {
+            WRITE_LOG(LOG_FATAL, "MallocSession new LoopShard failed");
+            delete hSession;
+            return nullptr;
+        }
+        ++shard->sessionCount;
+        hSession->loopShard = shard;
+        hSession->sharedLoop = &shard->loop;
+        (void)memset_s(hSession->ctrlPipe, sizeof(hSession->ctrlPipe), 0, sizeof(hSession->ctrlPipe));
+        (void)memset_s(hSession->dataPipe, sizeof(hSession->dataPipe), 0, sizeof(hSession->dataPipe));
+        (void)memset_s(&hSession->hChildWorkTCP, sizeof(hSession->hChildWorkTCP), 0, sizeof(uv_tcp_t));
+        // SP_STOP_SESSION walks the unused pipes too, their close callback needs the session
+        hSession->ctrlPipe[STREAM_WORK].data = hSession;
+        hSession->dataPipe[STREAM_WORK].data = hSession;
+        if (MallocSessionByConnectType(hSession)) {
+            --shard->sessionCount;
+            if (shard->privateLoop) {
+                CloseLoopShard(shard, "LoopShard");
+                delete shard;
+            }
+            delete hSession;
+            return nullptr;
+        }
+        AdminSession(OP_ADD, hSession->sessionId, hSession);
+        HdcTrace::Instant("session_new", "session", hSession->sessionId);
+        return hSession;
+    }
+    uv_loop_init(&hSession->childLoop);
     uv_tcp_init(&loopMain, &hSession->ctrlPipe[STREAM_MAIN]);
     (void)memset_s(&hSession->ctrlPipe[STREAM_WORK], sizeof(hSession->ctrlPipe[STREAM_WORK]),
                    0, sizeof(uv_tcp_t));
@@ -445,6 +565,7 @@ HSession HdcSessionBase::MallocSession(bool serverOrDaemon, const ConnType connT
         hSession = nullptr;
     } else {
         AdminSession(OP_ADD, hSession->sessionId, hSession);
+        HdcTrace::Instant("session_new", "session", hSession->sessionId);
     }
     return hSession;
 }
@@ -453,6 +574,12 @@ void HdcSessionBase::FreeSessionByConnectType(HSession hSession)
 {
     WRITE_LOG(LOG_DEBUG, "FreeSessionByConnectType %s", hSession->ToDebugString().c_str());
 
+    if (CONN_LOOPBACK == hSession->connType) {
+        HdcLoopback *pLoopback = (HdcLoopback *)hSession->classModule;
+        pLoopback->StopSession(hSession);
+        return;
+    }
+
     if (CONN_USB == hSession->connType) {
         // ibusb All context is applied for sub-threaded, so it needs to be destroyed in the subline
         if (!hSession->hUSB) {
@@ -520,12 +647,29 @@ void HdcSessionBase::FreeSessionFinally(uv_idle_t *handle)
     if (hSession->uvHandleRef > 0) {
         return;
     }
-    // Notify Server or Daemon, just UI or display commandline
-    thisClass->NotifyInstanceSessionFree(hSession, true);
-    // all hsession uv handle has been clear
-    thisClass->AdminSession(OP_REMOVE, hSession->sessionId, nullptr);
+    if (thisClass->AdminSession(OP_QUERY, hSession->sessionId, nullptr) == hSession) {
+        // Notify Server or Daemon, just UI or display commandline
+        thisClass->NotifyInstanceSessionFree(hSession, true);
+        // all hsession uv handle has been clear
+        thisClass->AdminSession(OP_REMOVE, hSession->sessionId, nullptr);
+    }
+    // removed under the write lock, no new ref can be taken, wait for queued ctrl and OP_QUERY_REF holders
+    if (hSession->ref > 0) {
+        return;
+    }
     WRITE_LOG(LOG_DEBUG, "!!!FreeSessionFinally sessionId:%u finish", hSession->sessionId);
     HdcAuth::FreeKey(!hSession->serverOrDaemon, hSession->listKey);
+    delete hSession->sendQueue;
+    hSession->sendQueue = nullptr;
+    if (hSession->loopShard) {
+        LoopShard *shard = (LoopShard *)hSession->loopShard;
+        --shard->sessionCount;
+        if (shard->privateLoop) {
+            // loop has been closed by PrivateLoopShardWorkThread or FreeSessionOpeate, closing is set and
+            // SendCtrlToWorkThread only runs on this main thread, so no sender can touch the shard any more
+            delete shard;
+        }
+    }
     delete hSession;
     hSession = nullptr;  // fix CodeMars SetNullAfterFree issue
     Base::TryCloseHandle((const uv_handle_t *)handle, Base::CloseIdleCallback);
@@ -549,8 +693,10 @@ void HdcSessionBase::FreeSessionContinue(HSession hSession)
         delete[] hSession->ioBuf;
         hSession->ioBuf = nullptr;
     }
-    Base::TryCloseHandle((uv_handle_t *)&hSession->ctrlPipe[STREAM_MAIN], true, closeSessionTCPHandle);
-    Base::TryCloseHandle((uv_handle_t *)&hSession->dataPipe[STREAM_MAIN], true, closeSessionTCPHandle);
+    if (!hSession->loopShard) {
+        Base::TryCloseHandle((uv_handle_t *)&hSession->ctrlPipe[STREAM_MAIN], true, closeSessionTCPHandle);
+        Base::TryCloseHandle((uv_handle_t *)&hSession->dataPipe[STREAM_MAIN], true, closeSessionTCPHandle);
+    }
     FreeSessionByConnectType(hSession);
     // finish
     Base::IdleUvTask(&loopMain, hSession, FreeSessionFinally);
@@ -572,10 +718,14 @@ void HdcSessionBase::FreeSessionOpeate(uv_timer_t *handle)
         return;
     }
 #endif
-    // wait workthread to free
-    if (hSession->ctrlPipe[STREAM_WORK].loop) {
+    LoopShard *shard = (LoopShard *)hSession->loopShard;
+    if (shard && shard->privateLoop && !shard->running) {
+        // work thread never started, loop and accepted socket can be closed here
+        CloseLoopShard(shard, "LoopShard");
+        thisClass->FreeSessionContinue(hSession);
+    } else if (shard || hSession->ctrlPipe[STREAM_WORK].loop) {  // wait workthread to free
         auto ctrl = BuildCtrlString(SP_STOP_SESSION, 0, nullptr, 0);
-        Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
+        thisClass->SendCtrlToWorkThread(hSession, ctrl);
         WRITE_LOG(LOG_DEBUG, "FreeSessionOpeate, send workthread fo free. sessionId:%u", hSession->sessionId);
         auto callbackCheckFreeSessionContinue = [](uv_timer_t *handle) -> void {
             HSession hSession = (HSession)handle->data;
@@ -606,6 +756,7 @@ void HdcSessionBase::FreeSession(const uint32_t sessionId)
             break;
         }
         hSession->isDead = true;
+        HdcTrace::Instant("session_free", "session", sessionId);
         Base::TimerUvTask(&loopMain, hSession, FreeSessionOpeate);
         NotifyInstanceSessionFree(hSession, false);
         WRITE_LOG(LOG_DEBUG, "FreeSession sessionId:%u ref:%u", hSession->sessionId, uint32_t(hSession->ref));
@@ -615,61 +766,84 @@ void HdcSessionBase::FreeSession(const uint32_t sessionId)
 HSession HdcSessionBase::AdminSession(const uint8_t op, const uint32_t sessionId, HSession hInput)
 {
     HSession hRet = nullptr;
+    SessionShard &shard = GetSessionShard(sessionId);
     switch (op) {
         case OP_ADD:
-            uv_rwlock_wrlock(&lockMapSession);
-            mapSession[sessionId] = hInput;
-            uv_rwlock_wrunlock(&lockMapSession);
+            uv_rwlock_wrlock(&shard.lock);
+            shard.mapSession[sessionId] = hInput;
+            uv_rwlock_wrunlock(&shard.lock);
             break;
         case OP_REMOVE:
-            uv_rwlock_wrlock(&lockMapSession);
-            mapSession.erase(sessionId);
-            uv_rwlock_wrunlock(&lockMapSession);
+            uv_rwlock_wrlock(&shard.lock);
+            shard.mapSession.erase(sessionId);
+            uv_rwlock_wrunlock(&shard.lock);
             break;
-        case OP_QUERY:
-            uv_rwlock_rdlock(&lockMapSession);
-            if (mapSession.count(sessionId)) {
-                hRet = mapSession[sessionId];
+        case OP_QUERY: {
+            uv_rwlock_rdlock(&shard.lock);
+            auto iter = shard.mapSession.find(sessionId);
+            if (iter != shard.mapSession.end()) {
+                hRet = iter->second;
             }
-            uv_rwlock_rdunlock(&lockMapSession);
+            uv_rwlock_rdunlock(&shard.lock);
             break;
-        case OP_QUERY_REF:
-            uv_rwlock_wrlock(&lockMapSession);
-            if (mapSession.count(sessionId)) {
-                hRet = mapSession[sessionId];
+        }
+        case OP_QUERY_REF: {
+            // ref is atomic, removal needs the write lock, so a read lock is enough here
+            uv_rwlock_rdlock(&shard.lock);
+            auto iter = shard.mapSession.find(sessionId);
+            if (iter != shard.mapSession.end()) {
+                hRet = iter->second;
                 ++hRet->ref;
             }
-            uv_rwlock_wrunlock(&lockMapSession);
+            uv_rwlock_rdunlock(&shard.lock);
             break;
-        case OP_UPDATE:
-            uv_rwlock_wrlock(&lockMapSession);
-            // remove old
-            mapSession.erase(sessionId);
-            mapSession[hInput->sessionId] = hInput;
-            uv_rwlock_wrunlock(&lockMapSession);
-            break;
-        case OP_VOTE_RESET:
-            if (mapSession.count(sessionId) == 0) {
-                break;
+        }
+        case OP_UPDATE: {
+            // remove old, always lock the lower shard first
+            SessionShard &shardNew = GetSessionShard(hInput->sessionId);
+            SessionShard *first = &shard < &shardNew ? &shard : &shardNew;
+            SessionShard *second = &shard < &shardNew ? &shardNew : &shard;
+            uv_rwlock_wrlock(&first->lock);
+            if (second != first) {
+                uv_rwlock_wrlock(&second->lock);
+            }
+            shard.mapSession.erase(sessionId);
+            shardNew.mapSession[hInput->sessionId] = hInput;
+            if (second != first) {
+                uv_rwlock_wrunlock(&second->lock);
             }
+            uv_rwlock_wrunlock(&first->lock);
+            break;
+        }
+        case OP_VOTE_RESET: {
             bool needReset;
             if (serverOrDaemon) {
-                uv_rwlock_wrlock(&lockMapSession);
-                hRet = mapSession[sessionId];
-                hRet->voteReset = true;
+                uv_rwlock_wrlock(&shard.lock);
+                auto iter = shard.mapSession.find(sessionId);
+                if (iter != shard.mapSession.end()) {
+                    hRet = iter->second;
+                    hRet->voteReset = true;
+                }
+                uv_rwlock_wrunlock(&shard.lock);
+                if (hRet == nullptr) {
+                    break;
+                }
                 needReset = true;
-                for (auto &kv : mapSession) {
-                    if (sessionId == kv.first) {
-                        continue;
+                EnumSessions([sessionId, &needReset](HSession hs) -> bool {
+                    if (sessionId == hs->sessionId) {
+                        return false;
                     }
                     WRITE_LOG(LOG_DEBUG, "session:%u vote reset, session %u is %s",
-                              sessionId, kv.first, kv.second->voteReset ? "YES" : "NO");
-                    if (!kv.second->voteReset) {
+                              sessionId, hs->sessionId, hs->voteReset ? "YES" : "NO");
+                    if (!hs->voteReset) {
                         needReset = false;
                     }
-                }
-                uv_rwlock_wrunlock(&lockMapSession);
+                    return false;
+                });
             } else {
+                if (AdminSession(OP_QUERY, sessionId, nullptr) == nullptr) {
+                    break;
+                }
                 needReset = true;
             }
             if (needReset) {
@@ -677,6 +851,7 @@ HSession HdcSessionBase::AdminSession(const uint8_t op, const uint32_t sessionId
                 abort();
             }
             break;
+        }
         default:
             break;
     }
@@ -704,6 +879,7 @@ HTaskInfo HdcSessionBase::AdminTask(const uint8_t op, HSession hSession, const u
             }
             mapTask[channelId] = hInput;
             hRet = hInput;
+            HdcTrace::Instant("task_new", "task", channelId);
 
             WRITE_LOG(LOG_DEBUG, "AdminTask add session %u, channelId %u, mapTask size: %zu",
                       hSession->sessionId, channelId, mapTask.size());
@@ -711,6 +887,7 @@ HTaskInfo HdcSessionBase::AdminTask(const uint8_t op, HSession hSession, const u
             break;
         case OP_REMOVE:
             mapTask.erase(channelId);
+            HdcTrace::Instant("task_free", "task", channelId);
             WRITE_LOG(LOG_DEBUG, "AdminTask rm session %u, channelId %u, mapTask size: %zu",
                       hSession->sessionId, channelId, mapTask.size());
             break;
@@ -732,26 +909,22 @@ int HdcSessionBase::SendByProtocol(HSession hSession, uint8_t *bufPtr, const int
 {
     if (hSession->isDead) {
         WRITE_LOG(LOG_WARN, "SendByProtocol session dead error");
+        delete[] bufPtr;
         return ERR_SESSION_NOFOUND;
     }
     int ret = 0;
+    uint64_t beginNs = uv_hrtime();
+    HdcTraceScope trace("SendByProtocol", "packet", hSession->sessionId, bufLen);
     switch (hSession->connType) {
         case CONN_TCP: {
-            WRITE_LOG(LOG_WARN, "CONN_TCP serverOrDaemon:%d", hSession->serverOrDaemon);
             if (echo && !hSession->serverOrDaemon) {
                 ret = Base::SendToStreamEx((uv_stream_t *)&hSession->hChildWorkTCP, bufPtr, bufLen,
                                            nullptr, (void *)FinishWriteSessionTCP, bufPtr);
             } else {
                 if (hSession->hWorkThread == uv_thread_self()) {
-
-                    WRITE_LOG(LOG_WARN, "CONN_TCP:%s serverOrDaemon:%d", bufPtr,
-                              hSession->serverOrDaemon);
-                    WRITE_LOG(LOG_WARN, "SendByProtocol %p  size:%lu", hSession->hWorkTCP, bufLen);
                     ret = Base::SendToStreamEx((uv_stream_t *)&hSession->hWorkTCP, bufPtr, bufLen,
                                                nullptr, (void *)FinishWriteSessionTCP, bufPtr);
                 } else if (hSession->hWorkChildThread == uv_thread_self()) {
-                    WRITE_LOG(LOG_WARN, "CONN_TCP 2:%s serverOrDaemon:%d", bufPtr,
-                              hSession->serverOrDaemon);
                     ret = Base::SendToStreamEx((uv_stream_t *)&hSession->hChildWorkTCP, bufPtr,
                                                bufLen, nullptr, (void *)FinishWriteSessionTCP,
                                                bufPtr);
@@ -762,6 +935,8 @@ int HdcSessionBase::SendByProtocol(HSession hSession, uint8_t *bufPtr, const int
             }
             if (ret > 0) {
                 ++hSession->ref;
+            } else {
+                delete[] bufPtr;
             }
             break;
         }
@@ -779,24 +954,45 @@ int HdcSessionBase::SendByProtocol(HSession hSession, uint8_t *bufPtr, const int
             break;
         }
 #endif
+        case CONN_LOOPBACK: {
+            HdcLoopback *pLoopback = (HdcLoopback *)hSession->classModule;
+            ret = pLoopback->SendLoopbackData(hSession, bufPtr, bufLen);
+            delete[] bufPtr;
+            break;
+        }
         default:
             break;
     }
+    hSession->stat.AddTime(hSession->stat.writeNs, beginNs);
     return ret;
 }
 
 int HdcSessionBase::Send(const uint32_t sessionId, const uint32_t channelId, const uint16_t commandFlag,
-                         const uint8_t *data, const int dataSize)
+                         const uint8_t *data, const int dataSize, const uint8_t *head, const int headSize)
 {
     HSession hSession = AdminSession(OP_QUERY, sessionId, nullptr);
     if (!hSession) {
         WRITE_LOG(LOG_DEBUG, "Send to offline device, drop it, sessionId:%u", sessionId);
         return ERR_SESSION_NOFOUND;
     }
+    return SendToSession(hSession, channelId, commandFlag, data, dataSize, head, headSize);
+}
+
+// hSession has been resolved by caller (task or channel cache), skip the session index lookup
+int HdcSessionBase::SendToSession(HSession hSession, const uint32_t channelId, const uint16_t commandFlag,
+                                  const uint8_t *data, const int dataSize, const uint8_t *head, const int headSize)
+{
+    int payloadSize = headSize + dataSize;
+    HdcTraceScope trace("SendToSession", "packet", channelId, payloadSize);
     PayloadProtect protectBuf;  // noneed convert to big-endian
     protectBuf.channelId = channelId;
     protectBuf.commandFlag = commandFlag;
-    protectBuf.checkSum = (ENABLE_IO_CHECKSUM && dataSize > 0) ? Base::CalcCheckSum(data, dataSize) : 0;
+    // byte sum, the head and data parts add up to the sum of the whole payload
+    protectBuf.checkSum = 0;
+    if (ENABLE_IO_CHECKSUM && payloadSize > 0) {
+        protectBuf.checkSum = static_cast<uint8_t>(Base::CalcCheckSum(head, headSize) +
+                                                   Base::CalcCheckSum(data, dataSize));
+    }
     protectBuf.vCode = payloadProtectStaticVcode;
     string s = SerialStruct::SerializeToString(protectBuf);
     // reserve for encrypt here
@@ -807,8 +1003,8 @@ int HdcSessionBase::Send(const uint32_t sessionId, const uint32_t channelId, con
     payloadHead.flag[1] = PACKET_FLAG.at(1);
     payloadHead.protocolVer = VER_PROTOCOL;
     payloadHead.headSize = htons(s.size());
-    payloadHead.dataSize = htonl(dataSize);
-    int finalBufSize = sizeof(PayloadHead) + s.size() + dataSize;
+    payloadHead.dataSize = htonl(payloadSize);
+    int finalBufSize = sizeof(PayloadHead) + s.size() + payloadSize;
     uint8_t *finayBuf = new uint8_t[finalBufSize]();
     if (finayBuf == nullptr) {
         WRITE_LOG(LOG_WARN, "send allocmem err");
@@ -825,7 +1021,12 @@ int HdcSessionBase::Send(const uint32_t sessionId, const uint32_t channelId, con
             WRITE_LOG(LOG_WARN, "send copyProtbuf err for dataSize:%d", dataSize);
             break;
         }
-        if (dataSize > 0 && memcpy_s(finayBuf + sizeof(PayloadHead) + s.size(), dataSize, data, dataSize)) {
+        uint8_t *payloadBuf = finayBuf + sizeof(PayloadHead) + s.size();
+        if (headSize > 0 && memcpy_s(payloadBuf, payloadSize, head, headSize)) {
+            WRITE_LOG(LOG_WARN, "send copyPayloadHead err for headSize:%d", headSize);
+            break;
+        }
+        if (dataSize > 0 && memcpy_s(payloadBuf + headSize, dataSize, data, dataSize)) {
             WRITE_LOG(LOG_WARN, "send copyDatabuf err for dataSize:%d", dataSize);
             break;
         }
@@ -836,11 +1037,21 @@ int HdcSessionBase::Send(const uint32_t sessionId, const uint32_t channelId, con
         WRITE_LOG(LOG_WARN, "send copywholedata err for dataSize:%d", dataSize);
         return ERR_BUF_COPY;
     }
-    if (CMD_KERNEL_ECHO == commandFlag) {
-        return SendByProtocol(hSession, finayBuf, finalBufSize, true);
+    bool echo = (CMD_KERNEL_ECHO == commandFlag);
+    int ret = 0;
+    HdcSendQueue *sendQueue = hSession->sendQueue;
+    if (sendQueue != nullptr && !hSession->isDead && uv_thread_self() == hSession->hWorkChildThread) {
+        ret = sendQueue->Push(channelId, commandFlag, finayBuf, finalBufSize, payloadSize, echo);
+    } else if (sendQueue != nullptr && !hSession->isDead && uv_thread_self() == threadSessionMain) {
+        // keep main thread packets, CMD_KERNEL_CHANNEL_CLOSE among them, behind the data already queued
+        ret = sendQueue->PushRemote(channelId, commandFlag, finayBuf, finalBufSize, payloadSize, echo);
     } else {
-        return SendByProtocol(hSession, finayBuf, finalBufSize);
+        ret = SendByProtocol(hSession, finayBuf, finalBufSize, echo);
     }
+    if (ret > 0) {
+        hSession->stat.CountOut(finalBufSize);
+    }
+    return ret;
 }
 
 int HdcSessionBase::DecryptPayload(HSession hSession, PayloadHead *payloadHeadBe, uint8_t *encBuf)
@@ -859,16 +1070,26 @@ int HdcSessionBase::DecryptPayload(HSession hSession, PayloadHead *payloadHeadBe
         WRITE_LOG(LOG_FATAL, "Session recv CalcCheckSum failed");
         return ERR_BUF_CHECK;
     }
+    if (hSession->handshakeOK && hSession->sendQueue != nullptr && uv_thread_self() == hSession->hWorkChildThread &&
+        hSession->sendQueue->OnRecvCommand(protectBuf.channelId, protectBuf.commandFlag, data, dataSize)) {
+        return RET_SUCCESS;
+    }
+    HdcTraceScope trace("FetchCommand", "packet", protectBuf.channelId, dataSize);
     if (!FetchCommand(hSession, protectBuf.channelId, protectBuf.commandFlag, data, dataSize)) {
         WRITE_LOG(LOG_WARN, "FetchCommand failed: channelId %x commandFlag %x",
                   protectBuf.channelId, protectBuf.commandFlag);
         return ERR_GENERIC;
     }
+    HdcSendQueue *sendQueue = hSession->sendQueue;
+    if (hSession->handshakeOK && sendQueue != nullptr && uv_thread_self() == hSession->hWorkChildThread) {
+        sendQueue->OnRecvConsumed(protectBuf.channelId, protectBuf.commandFlag, dataSize);
+    }
     return RET_SUCCESS;
 }
 
 int HdcSessionBase::OnRead(HSession hSession, uint8_t *bufPtr, const int bufLen)
 {
+    HdcTraceScope trace("OnRead", "packet", hSession->sessionId, bufLen);
     int ret = ERR_GENERIC;
     if (memcmp(bufPtr, PACKET_FLAG.c_str(), PACKET_FLAG.size())) {
         WRITE_LOG(LOG_FATAL, "PACKET_FLAG incorrect %x %x", bufPtr[0], bufPtr[1]);
@@ -889,6 +1110,7 @@ int HdcSessionBase::OnRead(HSession hSession, uint8_t *bufPtr, const int bufLen)
         return ERR_BUF_CHECK;
     }
     ret = packetHeadSize + tobeReadLen;
+    hSession->stat.CountIn(ret);
     return ret;
 }
 
@@ -906,6 +1128,7 @@ int HdcSessionBase::FetchIOBuf(HSession hSession, uint8_t *ioBuf, int read)
         return ERR_IO_FAIL;
     }
     hSession->availTailIndex += read;
+    uint64_t beginNs = uv_hrtime();
     while (!hSession->isDead && hSession->availTailIndex > static_cast<int>(sizeof(PayloadHead))) {
         childRet = ptrConnect->OnRead(hSession, ioBuf + indexBuf, hSession->availTailIndex);
         if (childRet > 0) {
@@ -921,6 +1144,7 @@ int HdcSessionBase::FetchIOBuf(HSession hSession, uint8_t *ioBuf, int read)
         }
         // It may be multi-time IO to merge in a BUF, need to loop processing
     }
+    hSession->stat.AddTime(hSession->stat.readNs, beginNs);
     if (indexBuf > 0 && hSession->availTailIndex > 0) {
         if (memmove_s(hSession->ioBuf, hSession->bufSize, hSession->ioBuf + indexBuf, hSession->availTailIndex)
             != EOK) {
@@ -952,6 +1176,9 @@ void HdcSessionBase::FinishWriteSessionTCP(uv_write_t *req, int status)
             WRITE_LOG(LOG_DEBUG, "FinishWriteSessionTCP freesession :%p", hSession);
             thisClass->FreeSession(hSession->sessionId);
         }
+    } else if (hSession->sendQueue != nullptr && uv_thread_self() == hSession->hWorkChildThread) {
+        // libuv write queue has drained a bit, send queue may hand over more
+        hSession->sendQueue->OnWriteFinish();
     }
     delete[]((uint8_t *)req->data);
     delete req;
@@ -1004,10 +1231,17 @@ bool HdcSessionBase::WorkThreadStartSession(HSession hSession)
 {
     bool regOK = false;
     int childRet = 0;
-    if (hSession->connType == CONN_TCP) {
+    if (hSession->connType == CONN_TCP && hSession->hChildWorkTCP.loop) {
+        // socket was accepted straight onto the session loop
+        HdcTCPBase *pTCPBase = (HdcTCPBase *)hSession->classModule;
+        hSession->hChildWorkTCP.data = hSession;
+        Base::SetTcpOptions((uv_tcp_t *)&hSession->hChildWorkTCP);
+        uv_read_start((uv_stream_t *)&hSession->hChildWorkTCP, AllocCallback, pTCPBase->ReadStream);
+        regOK = true;
+    } else if (hSession->connType == CONN_TCP) {
         HdcTCPBase *pTCPBase = (HdcTCPBase *)hSession->classModule;
         hSession->hChildWorkTCP.data = hSession;
-        if ((childRet = uv_tcp_init(&hSession->childLoop, &hSession->hChildWorkTCP)) < 0) {
+        if ((childRet = uv_tcp_init(hSession->GetWorkLoop(), &hSession->hChildWorkTCP)) < 0) {
             WRITE_LOG(LOG_DEBUG, "HdcSessionBase SessionCtrl failed 1");
             return false;
         }
@@ -1027,12 +1261,18 @@ bool HdcSessionBase::WorkThreadStartSession(HSession hSession)
         WRITE_LOG(LOG_DEBUG, "UART ReadyForWorkThread");
         regOK = pUARTBase->ReadyForWorkThread(hSession);
 #endif
+    } else if (hSession->connType == CONN_LOOPBACK) {
+        HdcLoopback *pLoopback = (HdcLoopback *)hSession->classModule;
+        regOK = pLoopback->ReadyForWorkThread(hSession);
     } else {  // USB
         HdcUSBBase *pUSBBase = (HdcUSBBase *)hSession->classModule;
         WRITE_LOG(LOG_DEBUG, "USB ReadyForWorkThread");
         regOK = pUSBBase->ReadyForWorkThread(hSession);
     }
 
+    if (regOK && hSession->sendQueue == nullptr) {
+        hSession->sendQueue = new(std::nothrow) HdcSendQueue(hSession, SEND_WINDOW_DEFAULT);
+    }
     if (regOK && hSession->serverOrDaemon) {
         // session handshake step1
         SessionHandShake handshake = {};
@@ -1085,18 +1325,32 @@ bool HdcSessionBase::DispatchMainThreadCommand(HSession hSession, const CtrlStru
         }
         case SP_STOP_SESSION: {
             WRITE_LOG(LOG_DEBUG, "Dispatch MainThreadCommand STOP_SESSION sessionId:%u", hSession->sessionId);
+            if (hSession->sendQueue != nullptr) {
+                hSession->sendQueue->Stop();
+            }
             auto closeSessionChildThreadTCPHandle = [](uv_handle_t *handle) -> void {
                 HSession hSession = (HSession)handle->data;
                 Base::TryCloseHandle((uv_handle_t *)handle);
-                if (--hSession->uvChildRef == 0) {
+                if (--hSession->uvChildRef > 0) {
+                    return;
+                }
+                if (hSession->loopShard) {
+                    // shared loop must keep running, clear the tasks in place
+                    HdcSessionBase *thisClass = (HdcSessionBase *)hSession->classInstance;
+                    thisClass->ReChildLoopForSessionClear(hSession);
+                } else {
                     uv_stop(&hSession->childLoop);
-                };
+                }
             };
             hSession->uvChildRef += 2;
             if (hSession->connType == CONN_TCP && hSession->hChildWorkTCP.loop) {  // maybe not use it
                 ++hSession->uvChildRef;
                 Base::TryCloseHandle((uv_handle_t *)&hSession->hChildWorkTCP, true, closeSessionChildThreadTCPHandle);
             }
+            if (hSession->connType == CONN_LOOPBACK && hSession->hLoopback != nullptr) {
+                ++hSession->uvChildRef;
+                ((HdcLoopback *)hSession->classModule)->StopReadWork(hSession, closeSessionChildThreadTCPHandle);
+            }
             Base::TryCloseHandle((uv_handle_t *)&hSession->ctrlPipe[STREAM_WORK], true,
                                  closeSessionChildThreadTCPHandle);
             Base::TryCloseHandle((uv_handle_t *)&hSession->dataPipe[STREAM_WORK], true,
@@ -1117,6 +1371,12 @@ bool HdcSessionBase::DispatchMainThreadCommand(HSession hSession, const CtrlStru
             DeatchChannel(hSession, channelId);
             break;
         }
+        case SP_FLUSH_SEND_QUEUE: {
+            if (hSession->sendQueue != nullptr) {
+                hSession->sendQueue->DrainRemote();
+            }
+            break;
+        }
         default:
             WRITE_LOG(LOG_WARN, "Not support main command");
             ret = false;
@@ -1160,6 +1420,190 @@ void HdcSessionBase::ReadCtrlFromMain(uv_stream_t *uvpipe, ssize_t nread, const
     delete[] buf->base;
 }
 
+// Main thread to session work thread, ctrl is built by BuildCtrlString
+int HdcSessionBase::SendCtrlToWorkThread(HSession hSession, const vector<uint8_t> &ctrl)
+{
+    if (!hSession->loopShard) {
+        return Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
+    }
+    if (ctrl.size() != sizeof(CtrlStruct)) {
+        return ERR_PARM_SIZE;
+    }
+    LoopShard *shard = (LoopShard *)hSession->loopShard;
+    CtrlStruct ctrlStruct;
+    if (memcpy_s(&ctrlStruct, sizeof(ctrlStruct), ctrl.data(), ctrl.size()) != EOK) {
+        return ERR_BUF_COPY;
+    }
+    std::lock_guard<std::mutex> lock(shard->mutexCtrl);
+    if (shard->closing) {
+        WRITE_LOG(LOG_DEBUG, "SendCtrlToWorkThread loop closed, sessionId:%u", hSession->sessionId);
+        return ERR_SESSION_DEAD;
+    }
+    // released after dispatch, FreeSessionFinally keeps the session until then
+    ++hSession->ref;
+    shard->listCtrl.push_back(std::make_pair(hSession, ctrlStruct));
+    uv_async_send(&shard->asyncCtrl);
+    return ctrl.size();
+}
+
+// Session work thread to main thread
+int HdcSessionBase::SendCtrlToMainThread(HSession hSession, const uint8_t *buf, const int bufLen)
+{
+    if (!hSession->loopShard) {
+        return Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_WORK], buf, bufLen);
+    }
+    PushAsyncMessage(hSession->sessionId, ASYNC_SESSION_CTRL, buf, bufLen);
+    return bufLen;
+}
+
+void HdcSessionBase::LoopShardAsyncCallback(uv_async_t *handle)
+{
+    LoopShard *shard = (LoopShard *)handle->data;
+    list<std::pair<HSession, CtrlStruct>> listCtrl;
+    bool stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutexCtrl);
+        listCtrl.swap(shard->listCtrl);
+        stopping = shard->stopping;
+    }
+    for (auto &item : listCtrl) {
+        HSession hSession = item.first;
+        if (item.second.command == SP_START_SESSION) {
+            hSession->hWorkChildThread = uv_thread_self();
+        }
+        shard->thisClass->DispatchMainThreadCommand(hSession, &item.second);
+        --hSession->ref;
+    }
+    if (stopping) {
+        uv_stop(&shard->loop);
+    }
+}
+
+void HdcSessionBase::PrivateLoopShardWorkThread(uv_work_t *arg)
+{
+    HSession hSession = (HSession)arg->data;
+    LoopShard *shard = (LoopShard *)hSession->loopShard;
+    hSession->hWorkChildThread = uv_thread_self();
+    HdcTrace::NameThread(Base::StringFormat("session %u", hSession->sessionId));
+    WRITE_LOG(LOG_DEBUG, "!!!Workthread run begin, sessionId:%u", hSession->sessionId);
+    uv_run(&shard->loop, UV_RUN_DEFAULT);
+    CloseLoopShard(shard, "Session childUV");
+    hSession->childCleared = true;
+    WRITE_LOG(LOG_DEBUG, "!!!Workthread run finish, sessionId:%u", hSession->sessionId);
+}
+
+// A private loop is not running yet, so the socket is accepted straight onto it and never crosses threads.
+// Running shared loops can not be touched from main thread, duplicate the socket to them as before.
+bool HdcSessionBase::AcceptTCPSession(uv_stream_t *server, HSession hSession)
+{
+    LoopShard *shard = (LoopShard *)hSession->loopShard;
+    if (shard && shard->privateLoop && !shard->running) {
+        Base::TryCloseHandle((uv_handle_t *)&hSession->hWorkTCP);
+        if (uv_tcp_init(&shard->loop, &hSession->hChildWorkTCP) < 0) {
+            return false;
+        }
+        hSession->hChildWorkTCP.data = hSession;
+        return uv_accept(server, (uv_stream_t *)&hSession->hChildWorkTCP) == 0;
+    }
+    if (uv_accept(server, (uv_stream_t *)&hSession->hWorkTCP) < 0) {
+        return false;
+    }
+    if ((hSession->fdChildWorkTCP = Base::DuplicateUvSocket(&hSession->hWorkTCP)) < 0) {
+        return false;
+    };
+    Base::TryCloseHandle((uv_handle_t *)&hSession->hWorkTCP);
+    return true;
+}
+
+// Commands queued before the work thread is up are delivered once its loop runs, no need to wait for it
+int HdcSessionBase::StartTCPSessionWork(HSession hSession)
+{
+    LoopShard *shard = (LoopShard *)hSession->loopShard;
+    if (shard == nullptr) {
+        return ERR_SESSION_NOFOUND;
+    }
+    if (shard->privateLoop && !shard->running) {
+        if (Base::StartWorkThread(&loopMain, PrivateLoopShardWorkThread, Base::FinishWorkThread, hSession) < 0) {
+            return ERR_API_FAIL;
+        }
+        shard->running = true;
+    }
+    auto ctrl = BuildCtrlString(SP_START_SESSION, 0, nullptr, 0);
+    return SendCtrlToWorkThread(hSession, ctrl);
+}
+
+void HdcSessionBase::LoopShardThread(void *arg)
+{
+    LoopShard *shard = (LoopShard *)arg;
+    HdcTrace::NameThread("session loop");
+    uv_run(&shard->loop, UV_RUN_DEFAULT);
+}
+
+// Call before any session is created, count 0 means one loop per cpu core
+bool HdcSessionBase::StartLoopShards(size_t count)
+{
+    if (!loopShards.empty()) {
+        return true;
+    }
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (count > SIZE_THREAD_POOL_MAX) {
+        count = SIZE_THREAD_POOL_MAX;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        LoopShard *shard = new(std::nothrow) LoopShard();
+        if (shard == nullptr) {
+            WRITE_LOG(LOG_FATAL, "StartLoopShards new shard failed");
+            break;
+        }
+        shard->sessionCount = 0;
+        shard->stopping = false;
+        shard->closing = false;
+        shard->thisClass = this;
+        uv_loop_init(&shard->loop);
+        uv_async_init(&shard->loop, &shard->asyncCtrl, LoopShardAsyncCallback);
+        shard->asyncCtrl.data = shard;
+        if (uv_thread_create(&shard->thread, LoopShardThread, shard) != 0) {
+            CloseLoopShard(shard, "LoopShard");
+            delete shard;
+            break;
+        }
+        loopShards.push_back(shard);
+    }
+    WRITE_LOG(LOG_INFO, "StartLoopShards session loops:%zu", loopShards.size());
+    return !loopShards.empty();
+}
+
+void HdcSessionBase::StopLoopShards()
+{
+    for (auto shard : loopShards) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutexCtrl);
+            shard->stopping = true;
+            uv_async_send(&shard->asyncCtrl);
+        }
+        uv_thread_join(&shard->thread);
+        CloseLoopShard(shard, "LoopShard");
+        delete shard;
+    }
+    loopShards.clear();
+}
+
+// Once closing is set no sender signals asyncCtrl any more, commands still queued are dropped with the loop
+void HdcSessionBase::CloseLoopShard(LoopShard *shard, const char *callerName)
+{
+    {
+        std::lock_guard<std::mutex> lock(shard->mutexCtrl);
+        shard->closing = true;
+        for (auto &item : shard->listCtrl) {
+            --item.first->ref;
+        }
+        shard->listCtrl.clear();
+    }
+    Base::TryCloseLoop(&shard->loop, callerName);
+}
+
 void HdcSessionBase::ReChildLoopForSessionClear(HSession hSession)
 {
     // Restart loop close task
@@ -1187,9 +1631,21 @@ void HdcSessionBase::ReChildLoopForSessionClear(HSession hSession)
         }
         // all task has been free
         uv_close((uv_handle_t *)handle, Base::CloseTimerCallback);
+        LoopShard *shard = (LoopShard *)hSession->loopShard;
+        if (shard && shard->privateLoop) {
+            uv_stop(&shard->loop);  // PrivateLoopShardWorkThread closes the loop then sets childCleared
+            return;
+        } else if (shard) {
+            hSession->childCleared = true;
+            return;
+        }
         uv_stop(&hSession->childLoop);  // stop ReChildLoopForSessionClear pendding
     };
-    Base::TimerUvTask(&hSession->childLoop, hSession, clearTaskForSessionFinish, (GLOBAL_TIMEOUT * TIME_BASE) / UV_DEFAULT_INTERVAL);
+    Base::TimerUvTask(hSession->GetWorkLoop(), hSession, clearTaskForSessionFinish,
+                      (GLOBAL_TIMEOUT * TIME_BASE) / UV_DEFAULT_INTERVAL);
+    if (hSession->loopShard) {
+        return;  // the shard loop keeps running, timer sets childCleared
+    }
     uv_run(&hSession->childLoop, UV_RUN_DEFAULT);
     // clear
     Base::TryCloseLoop(&hSession->childLoop, "Session childUV");
@@ -1214,6 +1670,7 @@ void HdcSessionBase::SessionWorkThread(uv_work_t *arg)
         WRITE_LOG(LOG_DEBUG, "SessionCtrl err2, %s fd:%d", buf, hSession->ctrlFd[STREAM_WORK]);
     }
     uv_read_start((uv_stream_t *)&hSession->ctrlPipe[STREAM_WORK], Base::AllocBufferCallback, ReadCtrlFromMain);
+    HdcTrace::NameThread(Base::StringFormat("session %u", hSession->sessionId));
     WRITE_LOG(LOG_DEBUG, "!!!Workthread run begin, sessionId:%u instance:%s", hSession->sessionId,
               thisClass->serverOrDaemon ? "server" : "daemon");
     uv_run(&hSession->childLoop, UV_RUN_DEFAULT);  // work pendding
@@ -1252,13 +1709,15 @@ bool HdcSessionBase::NeedNewTaskInfo(const uint16_t command, bool &masterTask)
         case CMD_APP_UNINSTALL:
         case CMD_UNITY_BUGREPORT_INIT:
         case CMD_APP_SIDELOAD:
+        case CMD_BENCH_INIT:
             taskMasterInit = true;
             break;
         default:
             break;
     }
-    if (!serverOrDaemon
-        && (command == CMD_SHELL_INIT || (command > CMD_UNITY_COMMAND_HEAD && command < CMD_UNITY_COMMAND_TAIL))) {
+    if (!serverOrDaemon && (command == CMD_SHELL_INIT || command == CMD_UNITY_STAT ||
+                            command == CMD_UNITY_BATCH_EXECUTE ||
+                            (command > CMD_UNITY_COMMAND_HEAD && command < CMD_UNITY_COMMAND_TAIL))) {
         // daemon's single side command
         ret = true;
     } else if (command == CMD_KERNEL_WAKEUP_SLAVETASK) {
@@ -1289,8 +1748,10 @@ bool HdcSessionBase::DispatchTaskData(HSession hSession, const uint32_t channelI
                 break;
             }
             hTaskInfo->channelId = channelId;
+            hTaskInfo->createNs = uv_hrtime();
             hTaskInfo->sessionId = hSession->sessionId;
-            hTaskInfo->runLoop = &hSession->childLoop;
+            hTaskInfo->ownerSession = hSession;
+            hTaskInfo->runLoop = hSession->GetWorkLoop();
             hTaskInfo->serverOrDaemon = serverOrDaemon;
             hTaskInfo->masterSlave = masterTask;
             hTaskInfo->closeRetryCount = 0;
@@ -1320,6 +1781,9 @@ bool HdcSessionBase::DispatchTaskData(HSession hSession, const uint32_t channelI
             WRITE_LOG(LOG_ALL, "Dead HTaskInfo, ignore, channelId:%u command:%u", channelId, command);
             break;
         }
+        ++hTaskInfo->packetsIn;
+        hTaskInfo->bytesIn += payloadSize;
+        HdcTraceScope trace("RedirectToTask", "task", channelId, payloadSize);
         ret = RedirectToTask(hTaskInfo, hSession, channelId, command, payload, payloadSize);
         break;
     }
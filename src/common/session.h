@@ -18,7 +18,7 @@
 #include "common.h"
 
 namespace Hdc {
-enum TaskType { TYPE_UNITY, TYPE_SHELL, TASK_FILE, TASK_FORWARD, TASK_APP };
+enum TaskType { TYPE_UNITY, TYPE_SHELL, TASK_FILE, TASK_FORWARD, TASK_APP, TASK_BENCH, TASK_BATCH };
 
 class HdcSessionBase {
 public:
@@ -88,7 +88,10 @@ public:
     void WorkerPendding();
     int OnRead(HSession hSession, uint8_t *bufPtr, const int bufLen);
     int Send(const uint32_t sessionId, const uint32_t channelId, const uint16_t commandFlag, const uint8_t *data,
-             const int dataSize);
+             const int dataSize, const uint8_t *head = nullptr, const int headSize = 0);
+    // head goes in front of data in the same payload, callers need not copy to prepend a few bytes
+    int SendToSession(HSession hSession, const uint32_t channelId, const uint16_t commandFlag, const uint8_t *data,
+                      const int dataSize, const uint8_t *head = nullptr, const int headSize = 0);
     int SendByProtocol(HSession hSession, uint8_t *bufPtr, const int bufLen, bool echo = false);
     virtual HSession AdminSession(const uint8_t op, const uint32_t sessionId, HSession hInput);
     virtual int FetchIOBuf(HSession hSession, uint8_t *ioBuf, int read);
@@ -102,6 +105,10 @@ public:
     virtual void EnumUARTDeviceRegister(UartKickoutZombie);
 #endif
     void ClearOwnTasks(HSession hSession, const uint32_t channelIDInput);
+    void EnumSessions(const std::function<bool(HSession)> &func);
+    static string ConnTypeName(const uint8_t connType);
+    string DumpSessionStat(HSession hSession, bool withTasks);
+    string DumpAllSessionStat();
     virtual bool FetchCommand(HSession hSession, const uint32_t channelId, const uint16_t command, uint8_t *payload,
                               int payloadSize)
     {
@@ -121,6 +128,11 @@ public:
         return wantRestart;
     }
     static vector<uint8_t> BuildCtrlString(InnerCtrlCommand command, uint32_t channelId, uint8_t *data, int dataSize);
+    int SendCtrlToWorkThread(HSession hSession, const vector<uint8_t> &ctrl);
+    int SendCtrlToMainThread(HSession hSession, const uint8_t *buf, const int bufLen);
+    bool StartLoopShards(size_t count);
+    int StartTCPSessionWork(HSession hSession);
+    bool AcceptTCPSession(uv_stream_t *server, HSession hSession);
     uv_loop_t loopMain;
     bool serverOrDaemon;
     uv_async_t asyncMainLoop;
@@ -201,9 +213,41 @@ private:
     bool WorkThreadStartSession(HSession hSession);
     uint32_t GetSessionPseudoUid();
     bool NeedNewTaskInfo(const uint16_t command, bool &masterTask);
+    void StopLoopShards();
+    static void LoopShardThread(void *arg);
+    static void LoopShardAsyncCallback(uv_async_t *handle);
+    static void PrivateLoopShardWorkThread(uv_work_t *arg);
 
-    map<uint32_t, HSession> mapSession;
-    uv_rwlock_t lockMapSession;
+    // TCP sessions run on a LoopShard, main thread commands are queued in memory and delivered by asyncCtrl,
+    // no socketpair is needed. In M:N mode sessions are multiplexed onto a fixed set of shards, otherwise each
+    // session owns a private shard which runs on a session work thread.
+    struct LoopShard {
+        uv_loop_t loop;
+        uv_async_t asyncCtrl;
+        uv_thread_t thread;
+        std::mutex mutexCtrl;  // also held over uv_async_send, so closing the loop can't race a sender
+        list<std::pair<HSession, CtrlStruct>> listCtrl;  // each queued command holds a session ref
+        std::atomic<uint32_t> sessionCount;
+        bool stopping;
+        bool closing;  // by mutexCtrl, the loop is being closed and asyncCtrl must not be signaled any more
+        bool privateLoop;  // owned by one session, freed with it
+        bool running;      // privateLoop only, work thread has been started, main thread access only
+        HdcSessionBase *thisClass;
+    };
+    static void CloseLoopShard(LoopShard *shard, const char *callerName);
+    vector<LoopShard *> loopShards;
+
+    // sessionId is random, low bits are enough to spread sessions over the shards
+    struct SessionShard {
+        uv_rwlock_t lock;
+        std::unordered_map<uint32_t, HSession> mapSession;
+    };
+    SessionShard &GetSessionShard(const uint32_t sessionId)
+    {
+        return sessionShards[sessionId & (SESSION_MAP_SHARDS - 1)];
+    }
+
+    SessionShard sessionShards[SESSION_MAP_SHARDS];
     std::atomic<uint32_t> sessionRef = 0;
     const uint8_t payloadProtectStaticVcode = 0x09;
     uv_thread_t threadSessionMain;
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "shell_pool.h"
+#ifndef HDC_HOST
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+namespace Hdc {
+namespace {
+    constexpr uint8_t CMD_HEAD_SIZE = 2;  // command length big endian, then the command
+    constexpr long FD_SCAN_MAX = 65536;
+    constexpr int FD_STATUS = STDERR_FILENO + 1;
+    constexpr size_t CLONE_STACK_SIZE = 65536;  // WorkerMain with its command buffer, until exec
+    // the subshell keeps an exit of the command from skipping the report, and does not see the status pipe
+    constexpr const char *SPLIT_SCRIPT = "(eval \"$1\") 3>&-; echo $? >&3";
+
+    // async-signal-safe, used by the forked worker
+    bool ReadFull(int fd, char *buf, size_t size)
+    {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t rc = read(fd, buf + done, size - done);
+            if (rc < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rc <= 0) {
+                return false;
+            }
+            done += rc;
+        }
+        return true;
+    }
+
+    bool PipeCloexec(int fds[2])
+    {
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+    }
+
+    void CloseFd(int &fd)
+    {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+HdcShellPool::~HdcShellPool()
+{
+    Stop();
+}
+
+HdcShellPool &HdcShellPool::Get()
+{
+    static HdcShellPool instance;
+    return instance;
+}
+
+void HdcShellPool::Start(uint32_t sizeIn)
+{
+    std::lock_guard<std::mutex> lock(mutexPool);
+    if (running || sizeIn == 0) {
+        return;
+    }
+    size = sizeIn;
+    running = true;
+    threadRefill = std::thread([this]() { RefillThread(); });
+    WRITE_LOG(LOG_DEBUG, "Shell pool start, size:%u", size);
+}
+
+void HdcShellPool::Stop()
+{
+    list<Worker> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutexPool);
+        if (!running) {
+            return;
+        }
+        running = false;
+        for (auto &idle : idleWorkers) {
+            workers.splice(workers.end(), idle);
+        }
+    }
+    condRefill.notify_all();
+    if (threadRefill.joinable()) {
+        threadRefill.join();
+    }
+    for (auto &worker : workers) {
+        CloseWorker(worker);
+    }
+}
+
+size_t HdcShellPool::IdleCount(bool pty)
+{
+    std::lock_guard<std::mutex> lock(mutexPool);
+    return idleWorkers[pty].size();
+}
+
+bool HdcShellPool::Launch(bool pty, const string &cmd, Worker &worker)
+{
+    bool warm = false;
+    if (cmd.size() < SHELL_POOL_CMD_MAX) {
+        std::lock_guard<std::mutex> lock(mutexPool);
+        list<Worker> &idle = idleWorkers[pty];
+        if (!idle.empty()) {
+            worker = idle.front();
+            idle.pop_front();
+            warm = true;
+        }
+    }
+    if (warm) {
+        condRefill.notify_one();
+        if (SendCommand(worker, cmd)) {
+            return true;
+        }
+        WRITE_LOG(LOG_WARN, "Shell pool worker %d lost, fork directly", worker.pid);
+        CloseWorker(worker);
+    }
+    return Spawn(pty, cmd.c_str(), worker);
+}
+
+bool HdcShellPool::LaunchSplit(const string &cmd, Worker &worker)
+{
+    return Spawn(false, cmd.c_str(), worker, true);
+}
+
+bool HdcShellPool::SendCommand(Worker &worker, const string &cmd)
+{
+    char head[CMD_HEAD_SIZE] = { static_cast<char>(cmd.size() >> CHAR_BIT), static_cast<char>(cmd.size()) };
+    string message(head, CMD_HEAD_SIZE);
+    message += cmd;
+    // far below the pipe capacity, never blocks on a live worker
+    size_t done = 0;
+    while (done < message.size()) {
+        ssize_t rc = write(worker.fdCtrl, message.data() + done, message.size() - done);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return false;
+        }
+        done += rc;
+    }
+    CloseFd(worker.fdCtrl);
+    return true;
+}
+
+void HdcShellPool::CloseWorker(Worker &worker)
+{
+    CloseFd(worker.fdCtrl);
+    CloseFd(worker.fdIO);
+    CloseFd(worker.fdErr);
+    CloseFd(worker.fdStatus);
+    if (worker.pid > 0) {
+        kill(worker.pid, SIGKILL);
+        waitpid(worker.pid, nullptr, 0);
+        worker.pid = 0;
+    }
+}
+
+void HdcShellPool::RefillThread()
+{
+    std::unique_lock<std::mutex> lock(mutexPool);
+    while (running) {
+        condRefill.wait(lock, [this]() {
+            return !running || idleWorkers[0].size() < size || idleWorkers[1].size() < size;
+        });
+        if (!running) {
+            break;
+        }
+        bool pty = idleWorkers[0].size() >= size;
+        lock.unlock();
+        Worker worker;
+        bool ret = Spawn(pty, nullptr, worker);
+        lock.lock();
+        if (!ret) {
+            // out of processes or fds, retry later instead of spinning
+            condRefill.wait_for(lock, std::chrono::seconds(1), [this]() { return !running; });
+            continue;
+        }
+        if (!running) {
+            CloseWorker(worker);
+            break;
+        }
+        idleWorkers[pty].push_back(worker);
+    }
+}
+
+bool HdcShellPool::Spawn(bool pty, const char *cmd, Worker &worker, bool split)
+{
+    string shellPath = Base::GetShellPath();
+    char ptsName[BUF_SIZE_SMALL] = "";
+    int fdCtrl[2] = { -1, -1 };
+    int fdOut[2] = { -1, -1 };
+    int fdErr[2] = { -1, -1 };
+    int fdStatus[2] = { -1, -1 };
+    int ptm = -1;
+    auto closeAll = [&]() {
+        CloseFd(fdCtrl[0]);
+        CloseFd(fdCtrl[1]);
+        CloseFd(fdOut[0]);
+        CloseFd(fdOut[1]);
+        CloseFd(fdErr[0]);
+        CloseFd(fdErr[1]);
+        CloseFd(fdStatus[0]);
+        CloseFd(fdStatus[1]);
+        CloseFd(ptm);
+    };
+    bool ret = cmd != nullptr || PipeCloexec(fdCtrl);
+    if (ret && pty) {
+        ptm = open("/dev/ptmx", O_RDWR | O_CLOEXEC);
+        ret = ptm >= 0 && grantpt(ptm) == 0 && unlockpt(ptm) == 0 && ptsname_r(ptm, ptsName, sizeof(ptsName)) == 0;
+    } else if (ret) {
+        ret = PipeCloexec(fdOut) && (!split || (PipeCloexec(fdErr) && PipeCloexec(fdStatus)));
+    }
+    if (!ret) {
+        char buf[BUF_SIZE_DEFAULT] = { 0 };
+        strerror_r(errno, buf, sizeof(buf));
+        WRITE_LOG(LOG_WARN, "Shell worker setup failed:%s", buf);
+        closeAll();
+        return false;
+    }
+    // everything the child needs is prepared here, after fork it only makes async-signal-safe calls
+    long maxFd = sysconf(_SC_OPEN_MAX);
+    SpawnArgs args = { pty, shellPath.c_str(), cmd, getenv("HOME"), ptsName, fdCtrl[0], fdOut[1], fdErr[1],
+                       fdStatus[1], (maxFd < 0 || maxFd > FD_SCAN_MAX) ? FD_SCAN_MAX : maxFd, {} };
+    pid_t pid = -1;
+    if (cmd != nullptr) {
+        pid = CloneExec(args);
+    } else if ((pid = fork()) == 0) {
+        // a warm worker runs on until it gets its command, it needs memory of its own
+        WorkerMain(args);
+    }
+    if (pid < 0) {
+        char buf[BUF_SIZE_DEFAULT] = { 0 };
+        strerror_r(errno, buf, sizeof(buf));
+        WRITE_LOG(LOG_WARN, "Start shell worker failed:%s", buf);
+        closeAll();
+        return false;
+    }
+    CloseFd(fdCtrl[0]);
+    CloseFd(fdOut[1]);
+    CloseFd(fdErr[1]);
+    CloseFd(fdStatus[1]);
+    worker.pid = pid;
+    worker.fdIO = pty ? ptm : fdOut[0];
+    worker.fdCtrl = fdCtrl[1];
+    worker.fdErr = fdErr[0];
+    worker.fdStatus = fdStatus[0];
+    return true;
+}
+
+// The child shares the memory of the daemon and the caller is suspended until it execs or exits, so no page tables
+// are copied. All signals stay blocked across clone, a handler of the daemon must never run in the child.
+pid_t HdcShellPool::CloneExec(SpawnArgs &args)
+{
+    std::unique_ptr<char[]> stack(new(std::nothrow) char[CLONE_STACK_SIZE]);
+    if (stack == nullptr) {
+        errno = ENOMEM;
+        return -1;
+    }
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &args.sigMask);
+    pid_t pid = clone(CloneMain, stack.get() + CLONE_STACK_SIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+    int err = errno;
+    pthread_sigmask(SIG_SETMASK, &args.sigMask, nullptr);
+    errno = err;
+    return pid;
+}
+
+int HdcShellPool::CloneMain(void *arg)
+{
+    const SpawnArgs &args = *static_cast<SpawnArgs *>(arg);
+    // without CLONE_SIGHAND the table is the child's own, caught signals fall back to default before unblocking
+    struct sigaction action = {};
+    for (int sig = 1; sig < NSIG; ++sig) {
+        if (sigaction(sig, nullptr, &action) == 0 && action.sa_handler != SIG_IGN && action.sa_handler != SIG_DFL) {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigaction(sig, &action, nullptr);
+        }
+    }
+    sigprocmask(SIG_SETMASK, &args.sigMask, nullptr);
+    WorkerMain(args);
+    return 1;
+}
+
+void HdcShellPool::WorkerMain(const SpawnArgs &args)
+{
+    setsid();
+    if (args.pty) {
+        int pts = open(args.ptsName, O_RDWR);
+        if (pts < 0) {
+            _exit(1);
+        }
+        dup2(pts, STDIN_FILENO);
+        dup2(pts, STDOUT_FILENO);
+        dup2(pts, STDERR_FILENO);
+        close(pts);
+        int fd = open("/proc/self/oom_score_adj", O_WRONLY);
+        if (fd >= 0) {
+            write(fd, "0", 1);
+            close(fd);
+        }
+        if ((args.home && chdir(args.home) < 0) || chdir("/")) {
+        }
+    } else if (args.fdErr >= 0) {
+        // moved above the targets first, so one dup2 cannot overwrite a pipe another still needs
+        int out = fcntl(args.fdOut, F_DUPFD, FD_STATUS + 1);
+        int err = fcntl(args.fdErr, F_DUPFD, FD_STATUS + 1);
+        int status = fcntl(args.fdStatus, F_DUPFD, FD_STATUS + 1);
+        if (out < 0 || err < 0 || status < 0) {
+            _exit(1);
+        }
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        dup2(status, FD_STATUS);
+        close(out);
+        close(err);
+        close(status);
+        execl(args.shellPath, args.shellPath, "-c", SPLIT_SCRIPT, "sh", args.cmd, nullptr);
+        _exit(1);
+    } else {
+        dup2(args.fdOut, STDOUT_FILENO);
+        dup2(args.fdOut, STDERR_FILENO);
+        close(args.fdOut);
+    }
+    const char *cmd = args.cmd;
+    char buf[SHELL_POOL_CMD_MAX + 1];
+    if (cmd == nullptr) {
+        // a waiting worker must not keep sockets or files of the daemon open, close everything but the command pipe
+        const int fdCtrl = STDERR_FILENO + 1;
+        if (args.fdCtrl != fdCtrl && dup2(args.fdCtrl, fdCtrl) < 0) {
+            _exit(1);
+        }
+        long fd = fdCtrl + 1;
+#ifdef SYS_close_range
+        if (syscall(SYS_close_range, fd, ~0U, 0) == 0) {
+            fd = args.maxFd;
+        }
+#endif
+        for (; fd < args.maxFd; ++fd) {
+            close(fd);
+        }
+        char head[CMD_HEAD_SIZE];
+        if (!ReadFull(fdCtrl, head, CMD_HEAD_SIZE)) {
+            _exit(0);  // dropped by the pool
+        }
+        size_t len = (static_cast<uint8_t>(head[0]) << CHAR_BIT) | static_cast<uint8_t>(head[1]);
+        if (len > SHELL_POOL_CMD_MAX || !ReadFull(fdCtrl, buf, len)) {
+            _exit(1);
+        }
+        buf[len] = '\0';
+        close(fdCtrl);
+        cmd = buf;
+    }
+    if (args.pty && *cmd == '\0') {
+        execl(args.shellPath, args.shellPath, "-", nullptr);
+    } else {
+        execl(args.shellPath, args.shellPath, "-c", cmd, nullptr);
+    }
+    _exit(1);
+}
+}  // namespace Hdc
+#endif
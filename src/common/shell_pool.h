@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_SHELL_POOL_H
+#define HDC_SHELL_POOL_H
+#include "common.h"
+#include <thread>
+
+namespace Hdc {
+// Warm shell workers of the daemon, for interactive shells and one-shot commands.
+// A worker is a child forked ahead by the refill thread. It already has its own session, its stdio on a PTY or on
+// an output pipe and no other fds of the daemon, and blocks on its control pipe; the command handed over there is
+// started with a single exec. Launch takes no lock over fork and starts a shell directly when no worker is ready.
+// A direct start borrows the memory of the daemon until exec like posix_spawn, so it costs the same however large
+// the daemon has grown; only the refill thread pays for fork, off the launch path.
+// The daemon keeps no workers unless persist.hdc.shell.pool asks for them.
+class HdcShellPool {
+public:
+    struct Worker {
+        pid_t pid = 0;
+        int fdIO = -1;    // ptm of a PTY worker, read end of stdout and stderr otherwise
+        int fdCtrl = -1;  // command pipe of a waiting worker
+        int fdErr = -1;     // LaunchSplit only, read end of stderr
+        int fdStatus = -1;  // LaunchSplit only, the exit code as text, nothing if the shell was killed
+    };
+    ~HdcShellPool();
+    static HdcShellPool &Get();
+    void Start(uint32_t sizeIn);  // warm workers per kind, 0 keeps the pool off
+    void Stop();
+    // "sh -c cmd", an empty cmd on a PTY starts the interactive "sh -"
+    bool Launch(bool pty, const string &cmd, Worker &worker);
+    // "sh -c cmd" with stdout, stderr and the exit code on separate pipes, always started directly
+    static bool LaunchSplit(const string &cmd, Worker &worker);
+    size_t IdleCount(bool pty);
+
+private:
+    struct SpawnArgs {
+        bool pty;
+        const char *shellPath;
+        const char *cmd;  // nullptr for a warm worker, which reads it from fdCtrl
+        const char *home;
+        const char *ptsName;
+        int fdCtrl;
+        int fdOut;
+        int fdErr;     // -1 when stderr shares fdOut
+        int fdStatus;
+        long maxFd;
+        sigset_t sigMask;  // of the launching thread, restored in the child before exec
+    };
+    static bool Spawn(bool pty, const char *cmd, Worker &worker, bool split = false);
+    static pid_t CloneExec(SpawnArgs &args);
+    static int CloneMain(void *arg);
+    static void WorkerMain(const SpawnArgs &args);
+    static bool SendCommand(Worker &worker, const string &cmd);
+    static void CloseWorker(Worker &worker);
+    void RefillThread();
+
+    std::mutex mutexPool;
+    std::condition_variable condRefill;
+    list<Worker> idleWorkers[2];  // indexed by pty
+    uint32_t size = 0;
+    bool running = false;
+    std::thread threadRefill;
+};
+}  // namespace Hdc
+
+#endif  // HDC_SHELL_POOL_H
@@ -35,6 +35,10 @@ HdcTaskBase::HdcTaskBase(HTaskInfo hTaskInfo)
 HdcTaskBase::~HdcTaskBase()
 {
     WRITE_LOG(LOG_DEBUG, "~HdcTaskBase channelId:%u", taskInfo->channelId);
+    HSession hSession = taskInfo->ownerSession;
+    if (hSession != nullptr && hSession->sendQueue != nullptr) {
+        hSession->sendQueue->CancelWaitWritable(this);
+    }
 }
 
 bool HdcTaskBase::ReadyForRelease()
@@ -50,13 +54,32 @@ void HdcTaskBase::TaskFinish()
     WRITE_LOG(LOG_DEBUG, "HdcTaskBase::TaskFinish notify");
 }
 
-bool HdcTaskBase::SendToAnother(const uint16_t command, uint8_t *bufPtr, const int size)
+// head, if any, is sent in front of bufPtr as one payload
+bool HdcTaskBase::SendToAnother(const uint16_t command, uint8_t *bufPtr, const int size, const uint8_t *head,
+                                const int headSize)
 {
     if (singalStop) {
         return false;
     }
     HdcSessionBase *sessionBase = reinterpret_cast<HdcSessionBase *>(taskInfo->ownerSessionClass);
-    return sessionBase->Send(taskInfo->sessionId, taskInfo->channelId, command, bufPtr, size) > 0;
+    int ret = 0;
+    if (taskInfo->ownerSession != nullptr) {
+        if (taskInfo->ownerSession->isDead) {
+            return false;
+        }
+        ret = sessionBase->SendToSession(taskInfo->ownerSession, taskInfo->channelId, command, bufPtr, size, head,
+                                          headSize);
+    } else {
+        ret = sessionBase->Send(taskInfo->sessionId, taskInfo->channelId, command, bufPtr, size, head, headSize);
+    }
+    if (ret <= 0) {
+        return false;
+    }
+    ++taskInfo->packetsOut;
+    taskInfo->bytesOut += headSize + size;
+    HdcLatency::Record(LAT_TASK_FIRST_DATA, taskInfo->createNs);
+    taskInfo->createNs = 0;
+    return true;
 }
 
 void HdcTaskBase::LogMsg(MessageLevel level, const char *msg, ...)
@@ -75,6 +98,24 @@ bool HdcTaskBase::ServerCommand(const uint16_t command, uint8_t *bufPtr, const i
     return hSession->ServerCommand(taskInfo->sessionId, taskInfo->channelId, command, bufPtr, size);
 }
 
+// Readers feeding the session (file, forward, shell) check this after each send and hold their next read
+bool HdcTaskBase::SessionWritePaused()
+{
+    HSession hSession = taskInfo->ownerSession;
+    return hSession != nullptr && hSession->sendQueue != nullptr && hSession->sendQueue->WritePaused();
+}
+
+// resume runs once on the task loop when the session drains below the low watermark or tasks are being cleared
+void HdcTaskBase::WaitSessionWritable(std::function<void()> resume)
+{
+    HSession hSession = taskInfo->ownerSession;
+    if (hSession == nullptr || hSession->sendQueue == nullptr) {
+        resume();
+        return;
+    }
+    hSession->sendQueue->WaitWritable(this, resume);
+}
+
 // cross thread
 int HdcTaskBase::ThreadCtrlCommunicate(const uint8_t *bufPtr, const int size)
 {
@@ -83,14 +124,13 @@ int HdcTaskBase::ThreadCtrlCommunicate(const uint8_t *bufPtr, const int size)
     if (!hSession) {
         return -1;
     }
-    uv_stream_t *handleStream = nullptr;
     if (uv_thread_self() == hSession->hWorkThread) {
-        handleStream = (uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN];
+        vector<uint8_t> ctrl(bufPtr, bufPtr + size);
+        return sessionBase->SendCtrlToWorkThread(hSession, ctrl);
     } else if (uv_thread_self() == hSession->hWorkChildThread) {
-        handleStream = (uv_stream_t *)&hSession->ctrlPipe[STREAM_WORK];
+        return sessionBase->SendCtrlToMainThread(hSession, bufPtr, size);
     } else {
         return ERR_GENERIC;
     }
-    return Base::SendToStream(handleStream, bufPtr, size);
 }
 }
@@ -36,10 +36,13 @@ public:
     void TaskFinish();
 
 protected:                                                                        // D/S==daemon/server
-    bool SendToAnother(const uint16_t command, uint8_t *bufPtr, const int size);  // D / S corresponds to the Task class
+    bool SendToAnother(const uint16_t command, uint8_t *bufPtr, const int size,  // D / S corresponds to the Task class
+                       const uint8_t *head = nullptr, const int headSize = 0);
     void LogMsg(MessageLevel level, const char *msg, ...);                        // D / S log Send to Client
     bool ServerCommand(const uint16_t command, uint8_t *bufPtr, const int size);  // D / s command is sent to Server
     int ThreadCtrlCommunicate(const uint8_t *bufPtr, const int size);             // main thread and session thread
+    bool SessionWritePaused();                                                    // session pending bytes too high
+    void WaitSessionWritable(std::function<void()> resume);                       // resume paused readers later
 
     uv_loop_t *loopTask;  // childuv pointer
     void *clsSession;
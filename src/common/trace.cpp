@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "trace.h"
+
+namespace Hdc {
+std::atomic<bool> HdcTrace::enabled(false);
+
+HdcTrace &HdcTrace::Get()
+{
+    static HdcTrace instance;
+    return instance;
+}
+
+bool HdcTrace::Start(const string &path)
+{
+    HdcTrace &instance = Get();
+    std::lock_guard<std::mutex> lock(instance.mutexFile);
+    if (instance.fileTrace != nullptr) {
+        return true;
+    }
+    instance.fileTrace = fopen(path.c_str(), "w");
+    if (instance.fileTrace == nullptr) {
+        WRITE_LOG(LOG_WARN, "Open trace file %s failed", path.c_str());
+        return false;
+    }
+    // the closing bracket is optional in the array format, a killed process still leaves a readable trace
+    fputs("[\n", instance.fileTrace);
+    instance.originNs = uv_hrtime();
+    instance.pid = uv_os_getpid();
+    enabled = true;
+    WRITE_LOG(LOG_INFO, "Trace events to %s", path.c_str());
+    return true;
+}
+
+void HdcTrace::Stop()
+{
+    if (!Enabled()) {
+        return;
+    }
+    enabled = false;
+    HdcTrace &instance = Get();
+    vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(instance.mutexBuffers);
+        buffers.swap(instance.vecBuffers);
+    }
+    for (auto &buffer : buffers) {
+        vector<TraceEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            events.swap(buffer->events);
+        }
+        instance.WriteEvents(events, buffer->tid);
+    }
+    std::lock_guard<std::mutex> lock(instance.mutexFile);
+    if (instance.fileTrace != nullptr) {
+        fputs("{}]\n", instance.fileTrace);
+        fclose(instance.fileTrace);
+        instance.fileTrace = nullptr;
+    }
+}
+
+HdcTrace::BufferHolder::~BufferHolder()
+{
+    if (buffer == nullptr) {
+        return;
+    }
+    vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        events.swap(buffer->events);
+    }
+    HdcTrace &instance = Get();
+    instance.WriteEvents(events, buffer->tid);
+    std::lock_guard<std::mutex> lock(instance.mutexBuffers);
+    auto it = std::find(instance.vecBuffers.begin(), instance.vecBuffers.end(), buffer);
+    if (it != instance.vecBuffers.end()) {
+        instance.vecBuffers.erase(it);
+    }
+}
+
+HdcTrace::TraceBuffer *HdcTrace::GetThreadBuffer()
+{
+    thread_local BufferHolder holder;
+    if (holder.buffer != nullptr) {
+        return holder.buffer.get();
+    }
+    std::shared_ptr<TraceBuffer> buffer = std::make_shared<TraceBuffer>();
+    buffer->events.reserve(TRACE_BUFFER_EVENTS);
+    {
+        std::lock_guard<std::mutex> lock(mutexBuffers);
+        buffer->tid = ++nextTid;
+        vecBuffers.push_back(buffer);
+    }
+    holder.buffer = buffer;
+    return buffer.get();
+}
+
+void HdcTrace::Push(const TraceEvent &event)
+{
+    TraceBuffer *buffer = GetThreadBuffer();
+    vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->events.push_back(event);
+        if (buffer->events.size() < TRACE_BUFFER_EVENTS) {
+            return;
+        }
+        events.swap(buffer->events);
+        buffer->events.reserve(TRACE_BUFFER_EVENTS);
+    }
+    WriteEvents(events, buffer->tid);
+}
+
+void HdcTrace::Complete(const char *name, const char *category, const uint64_t beginNs, const uint32_t id,
+                        const uint64_t size)
+{
+    if (beginNs == 0 || !Enabled()) {
+        return;
+    }
+    uint64_t now = uv_hrtime();
+    Get().Push({ name, category, beginNs, now > beginNs ? now - beginNs : 0, size, id, 'X' });
+}
+
+void HdcTrace::Instant(const char *name, const char *category, const uint32_t id, const uint64_t size)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Get().Push({ name, category, uv_hrtime(), 0, size, id, 'i' });
+}
+
+// metadata is written at once, the last name of a pooled thread wins in the viewer
+void HdcTrace::NameThread(const string &name)
+{
+    if (!Enabled()) {
+        return;
+    }
+    HdcTrace &instance = Get();
+    TraceBuffer *buffer = instance.GetThreadBuffer();
+    instance.WriteLine(Base::StringFormat("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+                                          "\"args\":{\"name\":\"%s\"}},\n", instance.pid, buffer->tid,
+                                          name.c_str()));
+}
+
+void HdcTrace::WriteEvents(const vector<TraceEvent> &events, const uint32_t tid)
+{
+    constexpr double nsPerUs = 1000.0;
+    string lines;
+    for (auto &event : events) {
+        double ts = event.beginNs > originNs ? (event.beginNs - originNs) / nsPerUs : 0;
+        lines += Base::StringFormat("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,", event.name,
+                                    event.category, event.phase, ts);
+        if (event.phase == 'X') {
+            lines += Base::StringFormat("\"dur\":%.3f,", event.durationNs / nsPerUs);
+        } else {
+            lines += "\"s\":\"t\",";
+        }
+        lines += Base::StringFormat("\"pid\":%u,\"tid\":%u,\"args\":{\"id\":%u,\"size\":%" PRIu64 "}},\n", pid, tid,
+                                    event.id, event.size);
+    }
+    WriteLine(lines);
+}
+
+void HdcTrace::WriteLine(const string &line)
+{
+    if (line.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutexFile);
+    if (fileTrace != nullptr) {
+        fwrite(line.c_str(), 1, line.size(), fileTrace);
+    }
+}
+}  // namespace Hdc
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_TRACE_H
+#define HDC_TRACE_H
+#include "common.h"
+
+namespace Hdc {
+// Opt-in event tracing in the Chrome JSON array format, open the file with chrome://tracing or ui.perfetto.dev.
+// Events go into a buffer of the calling thread and are written out when it is full, when the thread exits or on
+// Stop. When tracing is off every call costs one relaxed atomic load.
+// name and category must be string literals, only the pointers are kept until the event is written.
+class HdcTrace {
+public:
+    static bool Start(const string &path);
+    static void Stop();
+    static bool Enabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static uint64_t Begin()  // 0 when tracing is off, Complete ignores it
+    {
+        return Enabled() ? uv_hrtime() : 0;
+    }
+    static void Complete(const char *name, const char *category, const uint64_t beginNs, const uint32_t id = 0,
+                         const uint64_t size = 0);
+    static void Instant(const char *name, const char *category, const uint32_t id = 0, const uint64_t size = 0);
+    static void NameThread(const string &name);
+
+private:
+    struct TraceEvent {
+        const char *name;
+        const char *category;
+        uint64_t beginNs;
+        uint64_t durationNs;
+        uint64_t size;
+        uint32_t id;
+        char phase;
+    };
+    struct TraceBuffer {
+        std::mutex mutex;  // owner thread against Stop, never contended otherwise
+        vector<TraceEvent> events;
+        uint32_t tid;
+    };
+    struct BufferHolder {
+        std::shared_ptr<TraceBuffer> buffer;
+        ~BufferHolder();
+    };
+    static HdcTrace &Get();
+    TraceBuffer *GetThreadBuffer();
+    void Push(const TraceEvent &event);
+    void WriteEvents(const vector<TraceEvent> &events, const uint32_t tid);
+    void WriteLine(const string &line);
+
+    static std::atomic<bool> enabled;
+    std::mutex mutexBuffers;
+    vector<std::shared_ptr<TraceBuffer>> vecBuffers;
+    std::mutex mutexFile;
+    FILE *fileTrace = nullptr;
+    uint64_t originNs = 0;
+    uint32_t pid = 0;
+    uint32_t nextTid = 0;
+};
+
+// traces the enclosing block as one complete event
+class HdcTraceScope {
+public:
+    HdcTraceScope(const char *nameIn, const char *categoryIn, const uint32_t idIn = 0, const uint64_t sizeIn = 0)
+        : name(nameIn), category(categoryIn), id(idIn), size(sizeIn), beginNs(HdcTrace::Begin())
+    {
+    }
+    ~HdcTraceScope()
+    {
+        HdcTrace::Complete(name, category, beginNs, id, size);
+    }
+
+private:
+    const char *name;
+    const char *category;
+    uint32_t id;
+    uint64_t size;
+    uint64_t beginNs;
+};
+}  // namespace Hdc
+
+#endif  // HDC_TRACE_H
@@ -71,6 +71,7 @@ int HdcTransferBase::SimpleFileIO(CtxFile *context, uint64_t index, uint8_t *sen
         uv_fs_t *req = &ioContext->fs;
         ioContext->bufIO = buf;
         ioContext->context = context;
+        ioContext->traceNs = HdcTrace::Begin();
         req->data = ioContext;
         ++refCount;
         if (context->master) {  // master just read, and slave just write.when master/read, sendBuf can be nullptr
@@ -145,6 +146,7 @@ bool HdcTransferBase::SendIOPayload(CtxFile *context, int index, uint8_t *data,
     payloadHead.compressType = context->transferConfig.compressType;
     payloadHead.uncompressSize = dataSize;
     payloadHead.index = index;
+    uint64_t traceNs = HdcTrace::Begin();
     if (dataSize > 0) {
         switch (payloadHead.compressType) {
 #ifdef HARMONY_PROJECT
@@ -166,6 +168,7 @@ bool HdcTransferBase::SendIOPayload(CtxFile *context, int index, uint8_t *data,
         }
     }
     payloadHead.compressSize = compressSize;
+    HdcTrace::Complete("file_compress", "file", traceNs, taskInfo->channelId, dataSize);
     head = SerialStruct::SerializeToString(payloadHead);
     if (head.size() + 1 > payloadPrefixReserve) {
         delete[] sendBuf;
@@ -176,7 +179,9 @@ bool HdcTransferBase::SendIOPayload(CtxFile *context, int index, uint8_t *data,
         delete[] sendBuf;
         return false;
     }
+    traceNs = HdcTrace::Begin();
     bool ret = SendToAnother(commandData, sendBuf, payloadPrefixReserve + compressSize) > 0;
+    HdcTrace::Complete("file_send", "file", traceNs, taskInfo->channelId, payloadPrefixReserve + compressSize);
     delete[] sendBuf;
     return ret;
 }
@@ -187,6 +192,8 @@ void HdcTransferBase::OnFileIO(uv_fs_t *req)
     CtxFile *context = (CtxFile *)contextIO->context;
     HdcTransferBase *thisClass = (HdcTransferBase *)context->thisClass;
     uint8_t *bufIO = contextIO->bufIO;
+    HdcTrace::Complete(req->fs_type == UV_FS_READ ? "file_read" : "file_write", "file", contextIO->traceNs,
+                       thisClass->taskInfo->channelId, req->result > 0 ? req->result : 0);
     uv_fs_req_cleanup(req);
     while (true) {
         if (context->ioFinish) {
@@ -212,7 +219,15 @@ void HdcTransferBase::OnFileIO(uv_fs_t *req)
                 context->ioFinish = true;
                 break;
             }
-            if (context->indexIO < context->fileSize) {
+            if (context->indexIO < context->fileSize && thisClass->SessionWritePaused()) {
+                // hold the next read until the session write queue drains, the ref keeps task alive meanwhile
+                ++thisClass->refCount;
+                thisClass->WaitSessionWritable([thisClass, context]() {
+                    --thisClass->refCount;
+                    thisClass->SimpleFileIO(context, context->indexIO, nullptr,
+                                            Base::GetMaxBufSize() * thisClass->maxTransferBufFactor);
+                });
+            } else if (context->indexIO < context->fileSize) {
                 thisClass->SimpleFileIO(context, context->indexIO, nullptr,
                                         Base::GetMaxBufSize() * thisClass->maxTransferBufFactor);
             } else {
@@ -445,6 +460,7 @@ bool HdcTransferBase::RecvIOPayload(CtxFile *context, uint8_t *data, int dataSiz
         return false;
     }
     int clearSize = 0;
+    uint64_t traceNs = HdcTrace::Begin();
     if (pld.compressSize > 0) {
         switch (pld.compressType) {
 #ifdef HARMONY_PROJECT
@@ -464,6 +480,7 @@ bool HdcTransferBase::RecvIOPayload(CtxFile *context, uint8_t *data, int dataSiz
             }
         }
     }
+    HdcTrace::Complete("file_decompress", "file", traceNs, taskInfo->channelId, pld.compressSize);
     while (true) {
         if ((uint32_t)clearSize != pld.uncompressSize) {
             break;
@@ -112,6 +112,7 @@ private:
         uv_fs_t fs;
         uint8_t *bufIO;
         CtxFile *context;
+        uint64_t traceNs;
     };
     const uint8_t payloadPrefixReserve = 64;
     static void OnFileIO(uv_fs_t *req);
@@ -619,6 +619,14 @@ void HdcUARTBase::RequestSendPackage(uint8_t *data, const size_t length, bool qu
     NotifyTransfer();
 }
 
+void HdcUARTBase::CountRetransmit(const uint32_t sessionId)
+{
+    HSession hSession = GetSession(sessionId);
+    if (hSession != nullptr) {
+        ++hSession->stat.retransmits;
+    }
+}
+
 void HdcUARTBase::ProcessResponsePackage(const UartHead &head)
 {
     std::lock_guard<std::recursive_mutex> lock(mapOutPkgsMutex);
@@ -635,6 +643,7 @@ void HdcUARTBase::ProcessResponsePackage(const UartHead &head)
             WRITE_LOG(LOG_DEBUG, "UartPackageManager: erase pkgId:%s.", pkgId.c_str());
         } else {                           // response NAK
             it->pkgStatus = PKG_WAIT_SEND; // Re send the pkg
+            CountRetransmit(it->sessionId);
             WRITE_LOG(LOG_WARN, "UartPackageManager: resend pkgId:%s.", pkgId.c_str());
         }
     } else {
@@ -701,6 +710,7 @@ void HdcUARTBase::SendPkgInUARTOutMap()
                               it->ToDebugString().c_str());
                     it->pkgStatus = PKG_WAIT_SEND;
                     it->retryChance--;
+                    CountRetransmit(it->sessionId);
                     NotifyTransfer(); // make transfer reschedule
                     break;            // dont process anything now.
                 } else {
@@ -230,6 +230,7 @@ protected:
 
     virtual void RequestSendPackage(uint8_t *data, const size_t length, bool queue = true);
     virtual void ProcessResponsePackage(const UartHead &head);
+    void CountRetransmit(const uint32_t sessionId);
     virtual void SendPkgInUARTOutMap();
     virtual void ClearUARTOutMap(uint32_t sessionId);
     virtual void EnsureAllPkgsSent();
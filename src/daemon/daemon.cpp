@@ -30,6 +30,7 @@ HdcDaemon::HdcDaemon(bool serverOrDaemonIn)
 #ifdef HDC_SUPPORT_UART
     clsUARTServ = nullptr;
 #endif
+    clsLoopbackServ = nullptr;
     clsJdwp = nullptr;
     enableSecure = false;
 }
@@ -57,6 +58,10 @@ void HdcDaemon::ClearInstanceResource()
     }
     clsUARTServ = nullptr;
 #endif
+    if (clsLoopbackServ) {
+        delete (HdcLoopback *)clsLoopbackServ;
+        clsLoopbackServ = nullptr;
+    }
     if (clsJdwp) {
         delete (HdcJdwp *)clsJdwp;
         clsJdwp = nullptr;
@@ -81,6 +86,10 @@ void HdcDaemon::TryStopInstance()
         ((HdcDaemonUART *)clsUARTServ)->Stop();
     }
 #endif
+    if (clsLoopbackServ) {
+        WRITE_LOG(LOG_DEBUG, "Stop loopback");
+        ((HdcLoopback *)clsLoopbackServ)->Stop();
+    }
     ((HdcJdwp *)clsJdwp)->Stop();
     // workaround temply remove MainLoop instance clear
     ReMainLoopForInstanceClear();
@@ -139,6 +148,17 @@ void HdcDaemon::InitMod(bool bEnableTCP, bool bEnableUSB)
     enableSecure = (Base::Trim(secure) == "1");
 }
 
+// in-process link for tests, the server reaches it with LOOPBACK_KEY_PREFIX + name
+bool HdcDaemon::InitLoopback(const string &name)
+{
+    clsLoopbackServ = new(std::nothrow) HdcLoopback(false, this);
+    if (clsLoopbackServ == nullptr) {
+        WRITE_LOG(LOG_FATAL, "InitLoopback new clsLoopbackServ failed");
+        return false;
+    }
+    return ((HdcLoopback *)clsLoopbackServ)->Listen(name);
+}
+
 // clang-format off
 bool HdcDaemon::RedirectToTask(HTaskInfo hTaskInfo, HSession hSession, const uint32_t channelId,
                                const uint16_t command, uint8_t *payload, const int payloadSize)
@@ -154,10 +174,14 @@ bool HdcDaemon::RedirectToTask(HTaskInfo hTaskInfo, HSession hSession, const uin
         case CMD_UNITY_ROOTRUN:
         case CMD_UNITY_TERMINATE:
         case CMD_UNITY_BUGREPORT_INIT:
+        case CMD_UNITY_STAT:
         case CMD_JDWP_LIST:
         case CMD_JDWP_TRACK:
             ret = TaskCommandDispatch<HdcDaemonUnity>(hTaskInfo, TYPE_UNITY, command, payload, payloadSize);
             break;
+        case CMD_UNITY_BATCH_EXECUTE:
+            ret = TaskCommandDispatch<HdcDaemonBatch>(hTaskInfo, TASK_BATCH, command, payload, payloadSize);
+            break;
         case CMD_SHELL_INIT:
         case CMD_SHELL_DATA:
             ret = TaskCommandDispatch<HdcShell>(hTaskInfo, TYPE_SHELL, command, payload, payloadSize);
@@ -181,9 +205,18 @@ bool HdcDaemon::RedirectToTask(HTaskInfo hTaskInfo, HSession hSession, const uin
         case CMD_FORWARD_ACTIVE_SLAVE:
         case CMD_FORWARD_DATA:
         case CMD_FORWARD_FREE_CONTEXT:
+        case CMD_FORWARD_PAUSE:
+        case CMD_FORWARD_RESUME:
         case CMD_FORWARD_CHECK_RESULT:
             ret = TaskCommandDispatch<HdcDaemonForward>(hTaskInfo, TASK_FORWARD, command, payload, payloadSize);
             break;
+        case CMD_BENCH_START:
+        case CMD_BENCH_PING:
+        case CMD_BENCH_SINK:
+        case CMD_BENCH_ACK:
+        case CMD_BENCH_FINISH:
+            ret = TaskCommandDispatch<HdcBench>(hTaskInfo, TASK_BENCH, command, payload, payloadSize);
+            break;
         default:
             //ignore unknow command
             break;
@@ -268,7 +301,7 @@ bool HdcDaemon::DaemonSessionHandshake(HSession hSession, const uint32_t channel
             }
         } else
 #endif // HDC_SUPPORT_UART
-        if (clsUSBServ != nullptr) {
+        if (hSession->connType != CONN_LOOPBACK && clsUSBServ != nullptr) {
             (reinterpret_cast<HdcDaemonUSB *>(clsUSBServ))->OnNewHandshakeOK(hSession->sessionId);
         }
 
@@ -350,6 +383,12 @@ bool HdcDaemon::RemoveInstanceTask(const uint8_t op, HTaskInfo hTask)
         case TASK_APP:
             ret = DoTaskRemove<HdcDaemonApp>(hTask, op);
             break;
+        case TASK_BENCH:
+            ret = DoTaskRemove<HdcBench>(hTask, op);
+            break;
+        case TASK_BATCH:
+            ret = DoTaskRemove<HdcDaemonBatch>(hTask, op);
+            break;
         default:
             ret = false;
             break;
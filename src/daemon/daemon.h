@@ -30,6 +30,7 @@ public:
 #else
     void InitMod(bool bEnableTCP, bool bEnableUSB);
 #endif
+    bool InitLoopback(const string &name);
     bool FetchCommand(HSession hSession, const uint32_t channelId, const uint16_t command, uint8_t *payload,
                       const int payloadSize);
     bool ServerCommand(const uint32_t sessionId, const uint32_t channelId, const uint16_t command, uint8_t *bufPtr,
@@ -39,6 +40,7 @@ public:
 #ifdef HDC_SUPPORT_UART
     void *clsUARTServ;
 #endif
+    void *clsLoopbackServ;
     void *clsJdwp;
 
 private:
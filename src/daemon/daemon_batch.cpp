@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "daemon_batch.h"
+
+namespace Hdc {
+HdcDaemonBatch::HdcDaemonBatch(HTaskInfo hTaskInfo)
+    : HdcTaskBase(hTaskInfo)
+{
+}
+
+HdcDaemonBatch::~HdcDaemonBatch()
+{
+    WRITE_LOG(LOG_DEBUG, "HdcDaemonBatch deinit");
+}
+
+void HdcDaemonBatch::StopTask()
+{
+    singalStop = true;
+    nextCommand = vecCommands.size();
+    // a stopped reader may finish its item at once, which removes it from the list
+    list<BatchItem *> running = listRunning;
+    for (auto item : running) {
+        // the worker leads its own session, the group also holds what the command started in background
+        kill(-item->pid, SIGKILL);
+        for (auto &stream : item->streams) {
+            if (!stream.ended) {
+                stream.reader->StopWork(false, nullptr);
+            }
+        }
+    }
+}
+
+bool HdcDaemonBatch::CommandDispatch(const uint16_t command, uint8_t *payload, const int payloadSize)
+{
+    if (command != CMD_UNITY_BATCH_EXECUTE) {
+        return true;
+    }
+    string parameters(reinterpret_cast<char *>(payload), payloadSize);
+    if (!ParseCommands(parameters.c_str())) {
+        return false;
+    }
+    WRITE_LOG(LOG_DEBUG, "Batch %zu commands, parallel:%u", vecCommands.size(), parallel);
+    StartNext();
+    return true;
+}
+
+// [-j parallel] command...
+bool HdcDaemonBatch::ParseCommands(const char *parameters)
+{
+    int argc = 0;
+    char **argv = Base::SplitCommandToArgs(parameters, &argc);
+    bool ret = true;
+    int i = 0;
+    if (argv != nullptr && argc > 0 && !strcmp(argv[0], "-j")) {
+        char *end = nullptr;
+        uint64_t value = argc > 1 ? strtoull(argv[1], &end, 10) : 0;  // 10: decimal
+        if (argc < 2 || end == argv[1] || *end != '\0' || value == 0 || value > BATCH_PARALLEL_MAX) {  // 2: -j N
+            LogMsg(MSG_FAIL, "Batch parallelism must be 1-%u", BATCH_PARALLEL_MAX);
+            ret = false;
+        }
+        parallel = value;
+        i = 2;  // 2: -j and its value
+    }
+    for (; argv != nullptr && i < argc && ret; ++i) {
+        vecCommands.push_back(argv[i]);
+    }
+    if (argv != nullptr) {
+        delete[]((char *)argv);
+    }
+    if (ret && vecCommands.empty()) {
+        LogMsg(MSG_FAIL, "Batch needs at least one command");
+        ret = false;
+    }
+    return ret;
+}
+
+void HdcDaemonBatch::StartNext()
+{
+    while (!singalStop && listRunning.size() < parallel && nextCommand < vecCommands.size()) {
+        uint32_t id = nextCommand++;
+        if (!StartItem(id)) {
+            SendExit(id, -1);
+        }
+    }
+    if (!finished && !singalStop && listRunning.empty() && nextCommand >= vecCommands.size()) {
+        finished = true;
+        TaskFinish();
+    }
+}
+
+bool HdcDaemonBatch::StartItem(const uint32_t id)
+{
+    HdcShellPool::Worker worker;
+    if (!HdcShellPool::LaunchSplit(vecCommands[id], worker)) {
+        return false;
+    }
+    BatchItem *item = new(std::nothrow) BatchItem();
+    if (item == nullptr) {
+        WRITE_LOG(LOG_FATAL, "StartItem new item failed");
+        kill(-worker.pid, SIGKILL);
+        close(worker.fdIO);
+        close(worker.fdErr);
+        close(worker.fdStatus);
+        return false;
+    }
+    item->thisClass = this;
+    item->id = id;
+    item->pid = worker.pid;
+    int fds[STREAM_COUNT] = { worker.fdIO, worker.fdErr, worker.fdStatus };
+    for (int i = 0; i < STREAM_COUNT; ++i) {
+        BatchStream &stream = item->streams[i];
+        stream.item = item;
+        stream.fd = fds[i];
+        stream.ended = false;
+        stream.reader = new HdcFileDescriptor(loopTask, stream.fd, &stream, StreamRead, StreamFinish);
+    }
+    listRunning.push_back(item);
+    ++refCount;
+    for (auto &stream : item->streams) {
+        stream.reader->StartWork();
+        if (writeWaiting) {
+            stream.reader->PauseRead();
+        }
+    }
+    return true;
+}
+
+void HdcDaemonBatch::SendExit(const uint32_t id, const int code)
+{
+    string record = Base::StringFormat("%u exit %d\n", id, code);
+    SendToAnother(CMD_KERNEL_ECHO_RAW, (uint8_t *)record.c_str(), record.size());
+}
+
+bool HdcDaemonBatch::StreamRead(const void *context, uint8_t *buf, const int size)
+{
+    BatchStream *stream = (BatchStream *)context;
+    BatchItem *item = stream->item;
+    HdcDaemonBatch *thisClass = item->thisClass;
+    if (stream == &item->streams[STREAM_STATUS]) {
+        item->status.append((char *)buf, size);
+        return true;
+    }
+    string head = Base::StringFormat("%u %s %d\n", item->id, stream == &item->streams[STREAM_OUT] ? "out" : "err",
+                                     size);
+    if (!thisClass->SendToAnother(CMD_KERNEL_ECHO_RAW, buf, size, (uint8_t *)head.c_str(), head.size())) {
+        return false;
+    }
+    if (thisClass->SessionWritePaused()) {
+        thisClass->PauseStreams();
+    }
+    return true;
+}
+
+void HdcDaemonBatch::PauseStreams()
+{
+    if (writeWaiting) {
+        return;
+    }
+    writeWaiting = true;
+    for (auto item : listRunning) {
+        for (auto &stream : item->streams) {
+            if (!stream.ended) {
+                stream.reader->PauseRead();
+            }
+        }
+    }
+    WaitSessionWritable([this]() {
+        writeWaiting = false;
+        for (auto item : listRunning) {
+            for (auto &stream : item->streams) {
+                if (!stream.ended) {
+                    stream.reader->ResumeRead();
+                }
+            }
+        }
+    });
+}
+
+bool HdcDaemonBatch::StreamFinish(const void *context, const bool result, const string exitMsg)
+{
+    BatchStream *stream = (BatchStream *)context;
+    BatchItem *item = stream->item;
+    stream->ended = true;
+    for (auto &each : item->streams) {
+        if (!each.ended) {
+            return true;
+        }
+    }
+    item->thisClass->FinishItem(item);
+    return true;
+}
+
+void HdcDaemonBatch::FinishItem(BatchItem *item)
+{
+    SendExit(item->id, item->status.empty() ? -1 : atoi(item->status.c_str()));
+    listRunning.remove(item);
+    // readers are released by the loop once their last callback has returned
+    Base::IdleUvTask(loopTask, item, FreeItem);
+    StartNext();
+}
+
+void HdcDaemonBatch::FreeItem(uv_idle_t *handle)
+{
+    BatchItem *item = (BatchItem *)handle->data;
+    for (auto &stream : item->streams) {
+        if (!stream.reader->ReadyForRelease()) {
+            return;
+        }
+    }
+    for (auto &stream : item->streams) {
+        delete stream.reader;
+        close(stream.fd);
+    }
+    --item->thisClass->refCount;
+    delete item;
+    Base::TryCloseHandle((uv_handle_t *)handle, Base::CloseIdleCallback);
+}
+}  // namespace Hdc
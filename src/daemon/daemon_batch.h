@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_DAEMON_BATCH_H
+#define HDC_DAEMON_BATCH_H
+#include "daemon_common.h"
+
+namespace Hdc {
+// "hdc batch [-j N] COMMAND...", runs the commands over the one channel, at most N at a time.
+// The id of a command is its index in the list. Output is sent as it is read and the exit code when the command
+// ends, as CMD_KERNEL_ECHO_RAW records:
+//   "<id> out <size>\n" or "<id> err <size>\n", followed by size bytes of output
+//   "<id> exit <code>\n", code -1 when the shell could not start or ended without reporting it
+// The channel is closed after the last exit record.
+class HdcDaemonBatch : public HdcTaskBase {
+public:
+    HdcDaemonBatch(HTaskInfo hTaskInfo);
+    virtual ~HdcDaemonBatch();
+    bool CommandDispatch(const uint16_t command, uint8_t *payload, const int payloadSize);
+    void StopTask();
+
+private:
+    enum BatchStreamIndex { STREAM_OUT, STREAM_ERR, STREAM_STATUS, STREAM_COUNT };
+    struct BatchItem;
+    struct BatchStream {
+        BatchItem *item;
+        HdcFileDescriptor *reader;
+        int fd;
+        bool ended;
+    };
+    struct BatchItem {
+        HdcDaemonBatch *thisClass;
+        uint32_t id;
+        pid_t pid;
+        string status;  // the shell writes the exit code there, EOF comes when it has exited
+        BatchStream streams[STREAM_COUNT];
+    };
+    bool ParseCommands(const char *parameters);
+    void StartNext();
+    bool StartItem(const uint32_t id);
+    void FinishItem(BatchItem *item);
+    void PauseStreams();
+    void SendExit(const uint32_t id, const int code);
+    static bool StreamRead(const void *context, uint8_t *buf, const int size);
+    static bool StreamFinish(const void *context, const bool result, const string exitMsg);
+    static void FreeItem(uv_idle_t *handle);
+
+    vector<string> vecCommands;
+    list<BatchItem *> listRunning;
+    uint32_t nextCommand = 0;
+    uint32_t parallel = BATCH_PARALLEL_DEFAULT;
+    bool writeWaiting = false;
+    bool finished = false;
+};
+}  // namespace Hdc
+#endif  // HDC_DAEMON_BATCH_H
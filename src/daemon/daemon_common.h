@@ -19,6 +19,7 @@
 #include "../common/common.h"
 #include "../common/define.h"
 #include "../common/file.h"
+#include "../common/bench.h"
 #include "../common/forward.h"
 #include "../common/async_cmd.h"
 #include "../common/serial_struct.h"
@@ -28,6 +29,7 @@
 #include "jdwp.h"
 #include "daemon.h"
 #include "daemon_unity.h"
+#include "daemon_batch.h"
 #include "daemon_tcp.h"
 #include "daemon_app.h"
 #include "daemon_usb.h"
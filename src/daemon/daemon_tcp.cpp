@@ -59,30 +59,19 @@ void HdcDaemonTCP::TransmitConfig(const sockaddr *addrSrc, uv_udp_t *handle)
 
 void HdcDaemonTCP::AcceptClient(uv_stream_t *server, int status)
 {
-    uv_loop_t *ptrLoop = server->loop;
     uv_tcp_t *pServTCP = (uv_tcp_t *)server;
     HdcDaemonTCP *thisClass = (HdcDaemonTCP *)pServTCP->data;
     HdcSessionBase *ptrConnect = (HdcSessionBase *)thisClass->clsMainBase;
-    HdcSessionBase *daemon = reinterpret_cast<HdcSessionBase *>(thisClass->clsMainBase);
-    const uint16_t maxWaitTime = UV_DEFAULT_INTERVAL;
-    auto ctrl = daemon->BuildCtrlString(SP_START_SESSION, 0, nullptr, 0);
     HSession hSession = ptrConnect->MallocSession(false, CONN_TCP, thisClass);
     if (!hSession) {
         return;
     }
-    if (uv_accept(server, (uv_stream_t *)&hSession->hWorkTCP) < 0) {
+    if (!ptrConnect->AcceptTCPSession(server, hSession)) {
         goto Finish;
     }
-    if ((hSession->fdChildWorkTCP = Base::DuplicateUvSocket(&hSession->hWorkTCP)) < 0) {
+    if (ptrConnect->StartTCPSessionWork(hSession) < 0) {
         goto Finish;
-    };
-    Base::TryCloseHandle((uv_handle_t *)&hSession->hWorkTCP);
-    Base::StartWorkThread(ptrLoop, ptrConnect->SessionWorkThread, Base::FinishWorkThread, hSession);
-    // wait for thread up
-    while (hSession->childLoop.active_handles == 0) {
-        usleep(maxWaitTime);
     }
-    Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
     return;
 Finish:
     ptrConnect->FreeSession(hSession->sessionId);
@@ -216,8 +216,11 @@ HSession HdcDaemonUART::PrepareNewSession(uint32_t sessionId)
         WRITE_LOG(LOG_WARN, "New session coming, restart old sessionId:%u", currentSessionId);
         daemon.PushAsyncMessage(currentSessionId, ASYNC_FREE_SESSION, nullptr, 0);
     }
-    externInterface.StartWorkThread(&daemon.loopMain, daemon.SessionWorkThread,
-                                    Base::FinishWorkThread, hSession);
+    if (externInterface.StartWorkThread(&daemon.loopMain, daemon.SessionWorkThread, Base::FinishWorkThread,
+                                        hSession) < 0) {
+        daemon.FreeSession(sessionId);
+        return nullptr;
+    }
     auto funcNewSessionUp = [](uv_timer_t *handle) -> void {
         HSession hSession = reinterpret_cast<HSession>(handle->data);
         HdcDaemon &daemonSession = *reinterpret_cast<HdcDaemon *>(hSession->classInstance);
@@ -60,6 +60,10 @@ bool HdcDaemonUnity::AsyncCmdOut(bool finish, int64_t exitStatus, const string r
         if (!SendToAnother(currentDataCommand, (uint8_t *)result.c_str(), result.size())) {
             break;
         }
+        if (SessionWritePaused()) {
+            asyncCommand.Pause();
+            WaitSessionWritable([this]() { asyncCommand.Resume(); });
+        }
         ret = true;
     } while (false);
     if (wantFinish) {
@@ -292,6 +296,13 @@ bool HdcDaemonUnity::CommandDispatch(const uint16_t command, uint8_t *payload, c
             ExecuteShell((char *)CMDSTR_BUGREPORT.c_str());
             break;
         }
+        case CMD_UNITY_STAT: {
+            ret = false;
+            string echo = "device:\n" + daemon->DumpSessionStat(taskInfo->ownerSession, true) +
+                          HdcLatency::Dump(strPayload == "r");
+            LogMsg(MSG_OK, "%s", echo.c_str());
+            break;
+        }
         case CMD_JDWP_LIST: {
             ret = false;
             ListJdwpProcess(daemon);
@@ -226,6 +226,16 @@ void HdcDaemonUSB::ResetOldSession(uint32_t sessionId)
     daemon->FreeSession(sessionId);
 }
 
+// the read error belongs to the only usb session, if it is still there
+void HdcDaemonUSB::CountReadError()
+{
+    HdcDaemon *daemon = reinterpret_cast<HdcDaemon *>(clsMainBase);
+    HSession hSession = daemon->AdminSession(OP_QUERY, currentSessionId, nullptr);
+    if (hSession != nullptr) {
+        ++hSession->stat.usbErrors;
+    }
+}
+
 // Prevent other USB data misfortunes to send the program crash
 int HdcDaemonUSB::AvailablePacket(uint8_t *ioBuf, int ioBytes, uint32_t *sessionId)
 {
@@ -288,6 +298,7 @@ int HdcDaemonUSB::CloseBulkEp(bool bulkInOut, int bulkFd, uv_loop_t *loop)
 
 int HdcDaemonUSB::SendUSBIOSync(HSession hSession, HUSB hMainUSB, const uint8_t *data, const int length)
 {
+    HdcTraceScope trace("usb_bulk_in", "transport", hSession->sessionId, length);
     int bulkIn = hMainUSB->bulkIn;
     int childRet = 0;
     int ret = ERR_IO_FAIL;
@@ -313,6 +324,7 @@ int HdcDaemonUSB::SendUSBIOSync(HSession hSession, HUSB hMainUSB, const uint8_t
     if (offset == length) {
         ret = length;
     } else {
+        ++hSession->stat.usbErrors;
         WRITE_LOG(LOG_FATAL, "BulkinWrite write failed, nsize:%d really:%d modRunning:%d isAlive:%d SessionDead:%d",
                   length, offset, modRunning, isAlive, hSession->isDead);
     }
@@ -355,8 +367,12 @@ HSession HdcDaemonUSB::PrepareNewSession(uint32_t sessionId, uint8_t *pRecvBuf,
     if (!hChildSession) {
         return nullptr;
     }
+    if (Base::StartWorkThread(&daemon->loopMain, daemon->SessionWorkThread, Base::FinishWorkThread,
+                              hChildSession) < 0) {
+        daemon->FreeSession(sessionId);
+        return nullptr;
+    }
     currentSessionId = sessionId;
-    Base::StartWorkThread(&daemon->loopMain, daemon->SessionWorkThread, Base::FinishWorkThread, hChildSession);
     auto funcNewSessionUp = [](uv_timer_t *handle) -> void {
         HSession hChildSession = reinterpret_cast<HSession>(handle->data);
         HdcDaemon *daemon = reinterpret_cast<HdcDaemon *>(hChildSession->classInstance);
@@ -434,6 +450,7 @@ void HdcDaemonUSB::OnUSBRead(uv_fs_t *req)
     auto thisClass = reinterpret_cast<HdcDaemonUSB *>(ctxIo->thisClass);
     uint8_t *bufPtr = ctxIo->buf;
     ssize_t bytesIOBytes = req->result;
+    HdcTraceScope trace("usb_bulk_out", "transport", thisClass->currentSessionId, bytesIOBytes > 0 ? bytesIOBytes : 0);
     uint32_t sessionId = 0;
     bool ret = false;
     int childRet = 0;
@@ -454,6 +471,7 @@ void HdcDaemonUSB::OnUSBRead(uv_fs_t *req)
                 char buf[bufSize] = { 0 };
                 uv_strerror_r(bytesIOBytes, buf, bufSize);
                 WRITE_LOG(LOG_WARN, "USBIO ret:%d failed:%s", bytesIOBytes, buf);
+                thisClass->CountReadError();
                 ret = false;
                 break;
             } else {
@@ -51,6 +51,7 @@ private:
     int SendUSBIOSync(HSession hSession, HUSB hMainUSB, const uint8_t *data, const int length);
     int CloseBulkEp(bool bulkInOut, int bulkFd, uv_loop_t *loop);
     void ResetOldSession(uint32_t sessionId);
+    void CountReadError();
     int GetMaxPacketSize(int fdFfs);
     int UsbToHdcProtocol(uv_stream_t *stream, uint8_t *appendData, int dataSize);
     void FillUsbV2Head(struct usb_functionfs_desc_v2 &descUsbFfs);
@@ -93,6 +93,59 @@ size_t CheckUvThreadConfig()
     return nThreads;
 }
 
+size_t CheckSessionThreadConfig()
+{
+    string nThreadsString;
+    bool ret = SystemDepend::GetDevItem("persist.hdc.session.threads", nThreadsString);
+    if (!ret) {
+        return SIZE_SESSION_THREADS;
+    }
+    int nThreads = atoi(nThreadsString.c_str());
+    if (nThreads <= 0) {
+        return SIZE_SESSION_THREADS;
+    }
+    return nThreads;
+}
+
+// chrome trace of the packet pipeline, only when persist.hdc.trace names the output file
+void CheckTraceConfig()
+{
+    string tracePath;
+    if (SystemDepend::GetDevItem("persist.hdc.trace", tracePath) && !tracePath.empty()) {
+        HdcTrace::Start(tracePath);
+    }
+}
+
+// listen backlog of fport/rport listeners
+void CheckForwardBacklogConfig()
+{
+    string backlogString;
+    if (SystemDepend::GetDevItem("persist.hdc.forward.backlog", backlogString) && !backlogString.empty()) {
+        HdcForwardBase::SetListenBacklog(atoi(backlogString.c_str()));
+    }
+}
+
+// warm shell workers per kind, 0 disables the pool
+void CheckShellPoolConfig()
+{
+    uint32_t size = SHELL_POOL_SIZE_DEFAULT;
+    string sizeString;
+    if (SystemDepend::GetDevItem("persist.hdc.shell.pool", sizeString) && !sizeString.empty()) {
+        size = static_cast<uint32_t>(atoi(sizeString.c_str()));
+    }
+    HdcShellPool::Get().Start(size);
+}
+
+// M:N session loops, -1 disabled, 0 one loop per core
+int CheckSessionLoopConfig()
+{
+    string nLoopsString;
+    if (!SystemDepend::GetDevItem("persist.hdc.session.loops", nLoopsString) || nLoopsString.empty()) {
+        return -1;
+    }
+    return atoi(nLoopsString.c_str());
+}
+
 int BackgroundRun()
 {
     pid_t pc = fork();  // create process as daemon process
@@ -229,7 +282,15 @@ int main(int argc, const char *argv[])
     signal(SIGCHLD, SIG_IGN);
     signal(SIGALRM, SIG_IGN);
     WRITE_LOG(LOG_DEBUG, "HdcDaemon main run");
+    Base::SetWorkThreadLimit(CheckSessionThreadConfig());
+    CheckTraceConfig();
+    CheckForwardBacklogConfig();
+    CheckShellPoolConfig();
     HdcDaemon daemon(false, CheckUvThreadConfig());
+    int sessionLoops = CheckSessionLoopConfig();
+    if (sessionLoops >= 0) {
+        daemon.StartLoopShards(sessionLoops);
+    }
 
 #ifdef HDC_SUPPORT_UART
     daemon.InitMod(g_enableTcp, g_enableUsb, g_enableUart);
@@ -237,6 +298,8 @@ int main(int argc, const char *argv[])
     daemon.InitMod(g_enableTcp, g_enableUsb);
 #endif
     daemon.WorkerPendding();
+    HdcShellPool::Get().Stop();
+    HdcTrace::Stop();
     bool wantRestart = daemon.WantRestart();
     WRITE_LOG(LOG_DEBUG, "Daemon finish g_rootRun %d wantRestart %d", g_rootRun, wantRestart);
     // There is no daemon, we can only restart myself.
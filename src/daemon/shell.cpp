@@ -16,8 +16,6 @@
 #include <sys/wait.h>
 
 namespace Hdc {
-std::mutex HdcShell::mutexPty;
-
 HdcShell::HdcShell(HTaskInfo hTaskInfo)
     : HdcTaskBase(hTaskInfo)
 {
@@ -56,6 +54,7 @@ void HdcShell::StopTask()
     if (!childReady) {
         return;
     }
+    CloseCoalesceTimer();
     if (childShell) {
         childShell->StopWork(false, nullptr);
     }
@@ -115,108 +114,99 @@ bool HdcShell::CommandDispatch(const uint16_t command, uint8_t *payload, const i
     return true;
 }
 
-int HdcShell::ChildForkDo(int pts, const char *cmd, const char *arg0, const char *arg1)
+bool HdcShell::FinishShellProc(const void *context, const bool result, const string exitMsg)
 {
-    dup2(pts, STDIN_FILENO);
-    dup2(pts, STDOUT_FILENO);
-    dup2(pts, STDERR_FILENO);
-    close(pts);
-    string text = "/proc/self/oom_score_adj";
-    int fd = 0;
-    if ((fd = open(text.c_str(), O_WRONLY)) >= 0) {
-        write(fd, "0", 1);
-        close(fd);
-    }
-    char *env = nullptr;
-    if (((env = getenv("HOME")) && chdir(env) < 0) || chdir("/")) {
-    }
-    execl(cmd, cmd, arg0, arg1, nullptr);
-    _Exit(1);
-    return 0;
-}
+    WRITE_LOG(LOG_DEBUG, "FinishShellProc finish");
+    HdcShell *thisClass = (HdcShell *)context;
+    thisClass->FlushOutput();
+    thisClass->CloseCoalesceTimer();
+    thisClass->TaskFinish();
+    --thisClass->refCount;
+    return true;
+};
 
-int HdcShell::ShellFork(const char *cmd, const char *arg0, const char *arg1)
+bool HdcShell::SendOutput(uint8_t *buf, const int size)
 {
-    pid_t pid;
-    pid = fork();
-    if (pid < 0) {
-        constexpr int bufSize = 1024;
-        char buf[bufSize] = { 0 };
-        strerror_r(errno, buf, bufSize);
-        WRITE_LOG(LOG_DEBUG, "Fork shell failed:%s", buf);
-        return ERR_GENERIC;
-    }
-    if (pid == 0) {
-        HdcShell::mutexPty.unlock();
-        setsid();
-        close(ptm);
-        int pts = 0;
-        if ((pts = open(devname, O_RDWR | O_CLOEXEC)) < 0) {
-            return -1;
-        }
-        ChildForkDo(pts, cmd, arg0, arg1);
-        // proc finish
-    } else {
-        return pid;
+    if (!SendToAnother(CMD_KERNEL_ECHO_RAW, buf, size)) {
+        return false;
+    }
+    if (SessionWritePaused() && childShell != nullptr) {
+        childShell->PauseRead();
+        WaitSessionWritable([this]() {
+            if (childShell != nullptr) {
+                childShell->ResumeRead();
+            }
+        });
     }
-    return 0;
+    return true;
 }
 
-int HdcShell::CreateSubProcessPTY(const char *cmd, const char *arg0, const char *arg1, pid_t *pid)
+bool HdcShell::FlushOutput()
 {
-    ptm = open(devPTMX.c_str(), O_RDWR | O_CLOEXEC);
-    if (ptm < 0) {
-        constexpr int bufSize = 1024;
-        char buf[bufSize] = { 0 };
-        strerror_r(errno, buf, bufSize);
-        WRITE_LOG(LOG_DEBUG, "Cannot open ptmx, error:%s", buf);
-        return ERR_FILE_OPEN;
-    }
-    if (grantpt(ptm) || unlockpt(ptm)) {
-        constexpr int bufSize = 1024;
-        char buf[bufSize] = { 0 };
-        strerror_r(errno, buf, bufSize);
-        WRITE_LOG(LOG_DEBUG, "Cannot open2 ptmx, error:%s", buf);
-        close(ptm);
-        return ERR_API_FAIL;
-    }
-    if (ptsname_r(ptm, devname, sizeof(devname)) != 0) {
-        constexpr int bufSize = 1024;
-        char buf[bufSize] = { 0 };
-        strerror_r(errno, buf, bufSize);
-        WRITE_LOG(LOG_DEBUG, "Trouble with  ptmx, error:%s", buf);
-        close(ptm);
-        return ERR_API_FAIL;
-    }
-    *pid = ShellFork(cmd, arg0, arg1);
-    return ptm;
+    if (timerReady) {
+        uv_timer_stop(&timerCoalesce);
+    }
+    if (outputBatch.empty()) {
+        return true;
+    }
+    bool ret = SendOutput(outputBatch.data(), outputBatch.size());
+    outputBatch.clear();
+    return ret;
 }
 
-bool HdcShell::FinishShellProc(const void *context, const bool result, const string exitMsg)
+void HdcShell::CloseCoalesceTimer()
 {
-    WRITE_LOG(LOG_DEBUG, "FinishShellProc finish");
-    HdcShell *thisClass = (HdcShell *)context;
-    thisClass->TaskFinish();
-    --thisClass->refCount;
-    return true;
-};
+    if (!timerReady) {
+        return;
+    }
+    timerReady = false;
+    uv_timer_stop(&timerCoalesce);
+    Base::TryCloseHandle((uv_handle_t *)&timerCoalesce, true, [](uv_handle_t *handle) {
+        HdcShell *thisClass = (HdcShell *)handle->data;
+        --thisClass->refCount;
+    });
+}
 
+// The first read after SHELL_COALESCE_LATENCY without output is sent at once, so keystroke echo is not delayed.
+// Reads following closely are gathered and sent when SHELL_COALESCE_SIZE is reached or the budget expires.
 bool HdcShell::ChildReadCallback(const void *context, uint8_t *buf, const int size)
 {
     HdcShell *thisClass = (HdcShell *)context;
-    return thisClass->SendToAnother(CMD_KERNEL_ECHO_RAW, (uint8_t *)buf, size);
+    uint64_t now = uv_now(thisClass->loopTask);
+    bool quiet = now - thisClass->lastOutput >= SHELL_COALESCE_LATENCY;
+    thisClass->lastOutput = now;
+    vector<uint8_t> &batch = thisClass->outputBatch;
+    if (!thisClass->timerReady || (batch.empty() && quiet)) {
+        return thisClass->SendOutput(buf, size);
+    }
+    if (batch.size() + size > SHELL_COALESCE_SIZE && !thisClass->FlushOutput()) {
+        return false;
+    }
+    batch.insert(batch.end(), buf, buf + size);
+    if (batch.size() >= SHELL_COALESCE_SIZE) {
+        return thisClass->FlushOutput();
+    }
+    if (!uv_is_active((uv_handle_t *)&thisClass->timerCoalesce)) {
+        uv_timer_start(&thisClass->timerCoalesce, [](uv_timer_t *handle) {
+            HdcShell *thisClass = (HdcShell *)handle->data;
+            thisClass->FlushOutput();
+        }, SHELL_COALESCE_LATENCY, 0);
+    }
+    return true;
 };
 
 int HdcShell::StartShell()
 {
     WRITE_LOG(LOG_DEBUG, "StartShell...");
     int ret = 0;
-    HdcShell::mutexPty.lock();
     do {
-        if ((fdPTY = CreateSubProcessPTY(Base::GetShellPath().c_str(), "-", 0, &pidShell)) < 0) {
+        HdcShellPool::Worker worker;
+        if (!HdcShellPool::Get().Launch(true, STRING_EMPTY, worker)) {
             ret = ERR_PROCESS_SUB_FAIL;
             break;
         }
+        fdPTY = worker.fdIO;
+        pidShell = worker.pid;
         childShell = new(std::nothrow) HdcFileDescriptor(loopTask, fdPTY, this, ChildReadCallback, FinishShellProc);
         if (childShell == nullptr) {
             WRITE_LOG(LOG_FATAL, "StartShell new childShell failed");
@@ -229,6 +219,11 @@ int HdcShell::StartShell()
         }
         childReady = true;
         ++refCount;
+        if (uv_timer_init(loopTask, &timerCoalesce) == 0) {
+            timerCoalesce.data = this;
+            timerReady = true;
+            ++refCount;
+        }
     } while (false);
     if (ret != RET_SUCCESS) {
         if (pidShell > 0) {
@@ -236,7 +231,6 @@ int HdcShell::StartShell()
         }
         // fdPTY close by ~clase
     }
-    HdcShell::mutexPty.unlock();
     return ret;
 }
 }  // namespace Hdc
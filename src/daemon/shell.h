@@ -15,7 +15,6 @@
 #ifndef HDC_SHELL_H
 #define HDC_SHELL_H
 #include "daemon_common.h"
-#include <mutex>
 
 namespace Hdc {
 class HdcShell : public HdcTaskBase {
@@ -29,19 +28,19 @@ public:
 private:
     static bool FinishShellProc(const void *context, const bool result, const string exitMsg);
     static bool ChildReadCallback(const void *context, uint8_t *buf, const int size);
+    bool SendOutput(uint8_t *buf, const int size);
+    bool FlushOutput();
+    void CloseCoalesceTimer();
     int StartShell();
-    int CreateSubProcessPTY(const char *cmd, const char *arg0, const char *arg1, pid_t *pid);
-    int ChildForkDo(int pts, const char *cmd, const char *arg0, const char *arg1);
     bool SpecialSignal(uint8_t ch);
-    int ShellFork(const char *cmd, const char *arg0, const char *arg1);
 
     HdcFileDescriptor *childShell;
     pid_t pidShell = 0;
     int fdPTY;
-    int ptm = 0;
-    const string devPTMX = "/dev/ptmx";
-    static std::mutex mutexPty;
-    char devname[BUF_SIZE_SMALL] = "";
+    uv_timer_t timerCoalesce;
+    vector<uint8_t> outputBatch;
+    uint64_t lastOutput = 0;  // loop time in ms of the last pty read
+    bool timerReady = false;
 };
 }  // namespace Hdc
 #endif
\ No newline at end of file
@@ -143,6 +143,9 @@ string HdcClient::AutoConnectKey(string &doCommand, const string &preConnectKey)
     }
     if (isNoTargetCommand) {
         key = "";
+    } else if (!doCommand.compare(0, CMDSTR_STAT.size(), CMDSTR_STAT)) {
+        // without -t only the server counters are dumped
+        key = preConnectKey;
     } else {
         if (!preConnectKey.size()) {
             key = CMDSTR_CONNECT_ANY;
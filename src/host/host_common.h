@@ -18,6 +18,7 @@
 // clang-format off
 #include "../common/common.h"
 #include "../common/file.h"
+#include "../common/bench.h"
 #include "../common/transfer.h"
 #include "../common/forward.h"
 #include "../common/async_cmd.h"
@@ -98,7 +98,6 @@ void HdcHostTCP::Connect(uv_connect_t *connection, int status)
     HSession hSession = (HSession)connection->data;
     delete connection;
     HdcSessionBase *ptrConnect = (HdcSessionBase *)hSession->classInstance;
-    auto ctrl = ptrConnect->BuildCtrlString(SP_START_SESSION, 0, nullptr, 0);
     if (status < 0) {
         goto Finish;
     }
@@ -108,12 +107,9 @@ void HdcHostTCP::Connect(uv_connect_t *connection, int status)
     uv_read_stop((uv_stream_t *)&hSession->hWorkTCP);
     Base::SetTcpOptions((uv_tcp_t *)&hSession->hWorkTCP);
     WRITE_LOG(LOG_DEBUG, "HdcHostTCP::Connect");
-    Base::StartWorkThread(&ptrConnect->loopMain, ptrConnect->SessionWorkThread, Base::FinishWorkThread, hSession);
-    // wait for thread up
-    while (hSession->childLoop.active_handles == 0) {
-        uv_sleep(MINOR_TIMEOUT);
+    if (ptrConnect->StartTCPSessionWork(hSession) < 0) {
+        goto Finish;
     }
-    Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
     return;
 Finish:
     WRITE_LOG(LOG_FATAL, "Connect failed");
@@ -480,8 +480,11 @@ HSession HdcHostUART::ConnectDaemonByUart(const HSession hSession, const HDaemon
         return nullptr;
     }
 
-    externInterface.StartWorkThread(&server.loopMain, server.SessionWorkThread,
-                                    Base::FinishWorkThread, hSession);
+    if (externInterface.StartWorkThread(&server.loopMain, server.SessionWorkThread, Base::FinishWorkThread,
+                                        hSession) < 0) {
+        server.FreeSession(hSession->sessionId);
+        return nullptr;
+    }
     // wait for thread up
     while (hSession->childLoop.active_handles == 0) {
         uv_sleep(1);
@@ -481,6 +481,10 @@ void LIBUSB_CALL HdcHostUSB::USBBulkCallback(struct libusb_transfer *transfer)
         }
         return;
     }
+    if (ep->submitNs != 0) {
+        HdcLatency::Record(LAT_USB_TRANSFER, ep->submitNs);
+        ep->submitNs = 0;
+    }
     ep->isComplete = true;
     ep->cv.notify_one();
 }
@@ -500,12 +504,14 @@ int HdcHostUSB::SubmitUsbBio(HSession hSession, bool sendOrRecv, uint8_t *buf, i
         timeout = 0;  // infinity
         ep = &hUSB->hostBulkIn;
     }
+    HdcTraceScope trace(sendOrRecv ? "usb_bulk_out" : "usb_bulk_in", "transport", hSession->sessionId, bufSize);
     hUSB->lockDeviceHandle.lock();
     ep->isComplete = false;
     do {
         std::unique_lock<std::mutex> lock(ep->mutexIo);
         libusb_fill_bulk_transfer(ep->transfer, hUSB->devHandle, ep->endpoint, buf, bufSize, USBBulkCallback, ep,
                                   timeout);
+        ep->submitNs = sendOrRecv ? uv_hrtime() : 0;
         childRet = libusb_submit_transfer(ep->transfer);
         hUSB->lockDeviceHandle.unlock();
         if (childRet < 0) {
@@ -519,6 +525,9 @@ int HdcHostUSB::SubmitUsbBio(HSession hSession, bool sendOrRecv, uint8_t *buf, i
         }
         ret = ep->transfer->actual_length;
     } while (false);
+    if (ret < 0) {
+        ++hSession->stat.usbErrors;
+    }
     return ret;
 }
 
@@ -673,7 +682,11 @@ HSession HdcHostUSB::ConnectDetectDaemon(const HSession hSession, const HDaemonI
     hUSB->usbMountPoint = pdi->usbMountPoint;
     WRITE_LOG(LOG_DEBUG, "HSession HdcHostUSB::ConnectDaemon");
 
-    Base::StartWorkThread(&pServer->loopMain, pServer->SessionWorkThread, Base::FinishWorkThread, hSession);
+    if (Base::StartWorkThread(&pServer->loopMain, pServer->SessionWorkThread, Base::FinishWorkThread,
+                              hSession) < 0) {
+        pServer->FreeSession(hSession->sessionId);
+        return nullptr;
+    }
     // wait for thread up
     while (hSession->childLoop.active_handles == 0) {
         uv_sleep(1);
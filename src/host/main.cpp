@@ -67,6 +67,9 @@ int IsRegisterCommand(string &outCommand, const char *cmd, const char *cmdnext)
     registerCommand.push_back(CMDSTR_TARGET_REBOOT);
     registerCommand.push_back(CMDSTR_LIST_JDWP);
     registerCommand.push_back(CMDSTR_TRACK_JDWP);
+    registerCommand.push_back(CMDSTR_BENCH);
+    registerCommand.push_back(CMDSTR_STAT);
+    registerCommand.push_back(CMDSTR_BATCH);
 
     for (string v : registerCommand) {
         if (doubleCommand == v) {
@@ -128,14 +131,42 @@ int SplitOptionAndCommand(int argc, const char **argv, string &outOption, string
     return 0;
 }
 
+size_t GetThreadSizeFromEnv(const string &envName, size_t defaultSize)
+{
+    char *env = getenv(envName.c_str());
+    if (!env) {
+        return defaultSize;
+    }
+    int nThreads = atoi(env);
+    if (nThreads <= 0) {
+        return defaultSize;
+    }
+    return nThreads;
+}
+
 int RunServerMode(string &serverListenString)
 {
-    HdcServer server(true);
+    Base::SetWorkThreadLimit(GetThreadSizeFromEnv(ENV_SESSION_THREADS, SIZE_SESSION_THREADS));
+    HdcServer server(true, GetThreadSizeFromEnv(ENV_UV_THREADS, SIZE_THREAD_POOL));
+    char *envLoops = getenv(ENV_SESSION_LOOPS.c_str());
+    if (envLoops && atoi(envLoops) >= 0) {
+        server.StartLoopShards(atoi(envLoops));
+    }
+    char *envBacklog = getenv(ENV_FORWARD_BACKLOG.c_str());
+    if (envBacklog) {
+        HdcForwardBase::SetListenBacklog(atoi(envBacklog));
+    }
+    char *envTrace = getenv(ENV_TRACE.c_str());
+    if (envTrace && strlen(envTrace) > 0) {
+        HdcTrace::Start(envTrace);
+    }
     if (!server.Initial(serverListenString.c_str())) {
         Base::PrintMessage("Initial failed");
+        HdcTrace::Stop();
         return -1;
     }
     server.WorkerPendding();
+    HdcTrace::Stop();
     return 0;
 }
 
@@ -15,14 +15,15 @@
 #include "server.h"
 
 namespace Hdc {
-HdcServer::HdcServer(bool serverOrDaemonIn)
-    : HdcSessionBase(serverOrDaemonIn)
+HdcServer::HdcServer(bool serverOrDaemonIn, size_t uvThreadSize)
+    : HdcSessionBase(serverOrDaemonIn, uvThreadSize)
 {
     clsTCPClt = nullptr;
     clsUSBClt = nullptr;
 #ifdef HDC_SUPPORT_UART
     clsUARTClt = nullptr;
 #endif
+    clsLoopbackClt = nullptr;
     clsServerForClient = nullptr;
     uv_rwlock_init(&daemonAdmin);
     uv_rwlock_init(&forwardAdmin);
@@ -50,6 +51,9 @@ void HdcServer::ClearInstanceResource()
         delete clsUARTClt;
     }
 #endif
+    if (clsLoopbackClt) {
+        delete clsLoopbackClt;
+    }
     if (clsServerForClient) {
         delete (static_cast<HdcServerForClient *>(clsServerForClient));
     }
@@ -69,6 +73,9 @@ void HdcServer::TryStopInstance()
         clsUARTClt->Stop();
     }
 #endif
+    if (clsLoopbackClt) {
+        clsLoopbackClt->Stop();
+    }
     if (clsServerForClient) {
         ((HdcServerForClient *)clsServerForClient)->Stop();
     }
@@ -86,7 +93,8 @@ bool HdcServer::Initial(const char *listenString)
     clsServerForClient = new HdcServerForClient(true, listenString, this, &loopMain);
     clsTCPClt = new HdcHostTCP(true, this);
     clsUSBClt = new HdcHostUSB(true, this, ctxUSB);
-    if (!clsServerForClient || !clsTCPClt || !clsUSBClt) {
+    clsLoopbackClt = new HdcLoopback(true, this);
+    if (!clsServerForClient || !clsTCPClt || !clsUSBClt || !clsLoopbackClt) {
         WRITE_LOG(LOG_FATAL, "Class init failed");
         return false;
     }
@@ -230,6 +238,9 @@ void HdcServer::BuildDaemonVisableLine(HDaemonInfo hdi, bool fullDisplay, string
             case CONN_BT:
                 sConn = "BT";
                 break;
+            case CONN_LOOPBACK:
+                sConn = "LOOPBACK";
+                break;
             default:
                 sConn = "UNKNOW";
                 break;
@@ -374,6 +385,10 @@ string HdcServer::AdminDaemonMap(uint8_t opType, const string &connectKey, HDaem
 
 void HdcServer::NotifyInstanceSessionFree(HSession hSession, bool freeOrClear)
 {
+    HdcServerForClient *hSfc = static_cast<HdcServerForClient *>(clsServerForClient);
+    if (!freeOrClear && hSfc != nullptr) {
+        hSfc->DropTargetSession(hSession);
+    }
     HDaemonInfo hdiOld = nullptr;
     AdminDaemonMap(OP_QUERY, hSession->connectKey, hdiOld);
     if (hdiOld == nullptr) {
@@ -487,6 +502,10 @@ bool HdcServer::ServerSessionHandshake(HSession hSession, uint8_t *payload, int
     }
     AdminDaemonMap(OP_UPDATE, hSession->connectKey, hdiNew);
     hSession->handshakeOK = true;
+    if (hSession->sendQueue != nullptr) {
+        // daemon without flow control ignores it as a command of a dead channel 0 task
+        hSession->sendQueue->Announce();
+    }
     return true;
 }
 
@@ -739,7 +758,9 @@ void HdcServer::CreatConnectUart(HSession hSession)
 int HdcServer::CreateConnect(const string &connectKey)
 {
     uint8_t connType = 0;
-    if (connectKey.find(":") != std::string::npos) { // TCP
+    if (HdcLoopback::IsLoopbackKey(connectKey)) {
+        connType = CONN_LOOPBACK;
+    } else if (connectKey.find(":") != std::string::npos) { // TCP
         connType = CONN_TCP;
     }
 #ifdef HDC_SUPPORT_UART
@@ -770,6 +791,8 @@ int HdcServer::CreateConnect(const string &connectKey)
     HSession hSession = nullptr;
     if (CONN_TCP == connType) {
         hSession = clsTCPClt->ConnectDaemon(connectKey);
+    } else if (CONN_LOOPBACK == connType) {
+        hSession = clsLoopbackClt->ConnectDaemon(connectKey);
     } else if (CONN_SERIAL == connType) {
 #ifdef HDC_SUPPORT_UART
         hSession = clsUARTClt->ConnectDaemon(connectKey);
@@ -808,7 +831,7 @@ void HdcServer::AttachChannel(HSession hSession, const uint32_t channelId)
     if (!hChannel) {
         return;
     }
-    uv_tcp_init(&hSession->childLoop, &hChannel->hChildWorkTCP);
+    uv_tcp_init(hSession->GetWorkLoop(), &hChannel->hChildWorkTCP);
     hChannel->hChildWorkTCP.data = hChannel;
     hChannel->targetSessionId = hSession->sessionId;
     if ((ret = uv_tcp_open((uv_tcp_t *)&hChannel->hChildWorkTCP, hChannel->fdChildWorkTCP)) < 0) {
@@ -843,7 +866,7 @@ void HdcServer::DeatchChannel(HSession hSession, const uint32_t channelId)
     uint8_t count = 0;
     Send(hSession->sessionId, hChannel->channelId, CMD_KERNEL_CHANNEL_CLOSE, &count, 1);
     if (uv_is_closing((const uv_handle_t *)&hChannel->hChildWorkTCP)) {
-        Base::DoNextLoop(&hSession->childLoop, hChannel, [](const uint8_t flag, string &msg, const void *data) {
+        Base::DoNextLoop(hSession->GetWorkLoop(), hChannel, [](const uint8_t flag, string &msg, const void *data) {
             HChannel hChannel = (HChannel)data;
             hChannel->childCleared = true;
             WRITE_LOG(LOG_DEBUG, "Childchannel free direct, cid:%u", hChannel->channelId);
@@ -895,6 +918,8 @@ bool HdcServer::RedirectToTask(HTaskInfo hTaskInfo, HSession hSession, const uin
         case CMD_FORWARD_ACTIVE_SLAVE:
         case CMD_FORWARD_DATA:
         case CMD_FORWARD_FREE_CONTEXT:
+        case CMD_FORWARD_PAUSE:
+        case CMD_FORWARD_RESUME:
             ret = TaskCommandDispatch<HdcHostForward>(hTaskInfo, TASK_FORWARD, command, payload, payloadSize);
             break;
         case CMD_APP_INIT:
@@ -904,6 +929,14 @@ bool HdcServer::RedirectToTask(HTaskInfo hTaskInfo, HSession hSession, const uin
         case CMD_APP_UNINSTALL:
             ret = TaskCommandDispatch<HdcHostApp>(hTaskInfo, TASK_APP, command, payload, payloadSize);
             break;
+        case CMD_BENCH_INIT:
+        case CMD_BENCH_READY:
+        case CMD_BENCH_PONG:
+        case CMD_BENCH_SOURCE:
+        case CMD_BENCH_ACK:
+        case CMD_BENCH_FINISH:
+            ret = TaskCommandDispatch<HdcBench>(hTaskInfo, TASK_BENCH, command, payload, payloadSize);
+            break;
         default:
             // ignore unknow command
             break;
@@ -930,6 +963,9 @@ bool HdcServer::RemoveInstanceTask(const uint8_t op, HTaskInfo hTask)
         case TASK_APP:
             ret = DoTaskRemove<HdcHostApp>(hTask, op);
             break;
+        case TASK_BENCH:
+            ret = DoTaskRemove<HdcBench>(hTask, op);
+            break;
         default:
             ret = false;
             break;
@@ -19,7 +19,7 @@
 namespace Hdc {
 class HdcServer : public HdcSessionBase {
 public:
-    HdcServer(bool serverOrDaemonIn);
+    HdcServer(bool serverOrDaemonIn, size_t uvThreadSize = SIZE_THREAD_POOL);
     virtual ~HdcServer();
     bool FetchCommand(HSession hSession, const uint32_t channelId, const uint16_t command, uint8_t *payload,
                       const int payloadSize);
@@ -42,6 +42,7 @@ public:
     static void UartPreConnect(uv_timer_t *handle);
     HdcHostUART *clsUARTClt = nullptr;
 #endif
+    HdcLoopback *clsLoopbackClt;
     void *clsServerForClient;
 
 private:
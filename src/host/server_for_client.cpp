@@ -117,11 +117,13 @@ void HdcServerForClient::EchoClient(HChannel hChannel, MessageLevel level, const
     if (log.back() != '\n') {
         log += "\r\n";
     }
+    HdcLatency::Record(LAT_CLIENT_ECHO, hChannel->commandBeginNs.exchange(0));
     SendChannel(hChannel, (uint8_t *)log.c_str(), log.size());
 }
 
 void HdcServerForClient::EchoClientRaw(const HChannel hChannel, uint8_t *payload, const int payloadSize)
 {
+    HdcLatency::Record(LAT_CLIENT_ECHO, hChannel->commandBeginNs.exchange(0));
     SendChannel(hChannel, payload, payloadSize);
 }
 
@@ -130,6 +132,20 @@ bool HdcServerForClient::SendToDaemon(HChannel hChannel, const uint16_t commandF
     HDaemonInfo hdi = nullptr;
     bool ret = false;
     HdcServer *ptrServer = (HdcServer *)clsServer;
+    // Channel has been attached, the session is cached by main thread and dropped by FreeSession before its
+    // SP_STOP_SESSION. Other readers run on the session work thread, it can't be deleted under them.
+    if (hChannel->targetSessionId != 0) {
+        HSession hSession = hChannel->targetSession;
+        if (hSession == nullptr) {
+            hSession = FindAliveSession(hChannel->targetSessionId);
+            if (hSession != nullptr && uv_thread_self() == hChannel->hWorkThread) {
+                hChannel->targetSession = hSession;
+            }
+        }
+        if (hSession && !hSession->isDead && hSession->handshakeOK) {
+            return ptrServer->SendToSession(hSession, hChannel->channelId, commandFlag, bufPtr, bufSize) >= 0;
+        }
+    }
     while (true) {
         ptrServer->AdminDaemonMap(OP_QUERY, hChannel->connectKey, hdi);
         if (hdi == nullptr) {
@@ -397,6 +413,12 @@ bool HdcServerForClient::DoCommandLocal(HChannel hChannel, void *formatCommandIn
             RemoveForward(hChannel, parameterString);
             break;
         }
+        case CMD_KERNEL_STAT: {
+            string echo = ptrServer->DumpAllSessionStat() + DumpChannelStat(0) +
+                          HdcLatency::Dump(formatCommand->parameters == "r");
+            EchoClientRaw(hChannel, (uint8_t *)echo.c_str(), echo.size());
+            break;
+        }
         case CMD_KERNEL_ENABLE_KEEPALIVE: {
             // just use for 'list targets' now
             hChannel->keepAlive = true;
@@ -436,6 +458,9 @@ bool HdcServerForClient::TaskCommand(HChannel hChannel, void *formatCommandInput
     } else if (CMD_APP_SIDELOAD == formatCommand->cmdFlag) {
         cmdFlag = "sideload ";
         sizeCmdFlag = 9;
+    } else if (CMD_BENCH_INIT == formatCommand->cmdFlag) {
+        cmdFlag = "bench ";
+        sizeCmdFlag = 6;  // 6: cmdFlag bench size
     }
     uint8_t *payload = reinterpret_cast<uint8_t *>(const_cast<char *>(formatCommand->parameters.c_str())) + sizeCmdFlag;
     if (!strncmp(formatCommand->parameters.c_str(), cmdFlag.c_str(), sizeCmdFlag)) {  // local do
@@ -462,6 +487,7 @@ bool HdcServerForClient::DoCommandRemote(HChannel hChannel, void *formatCommandI
         case CMD_SHELL_INIT:
         case CMD_SHELL_DATA:
         case CMD_UNITY_EXECUTE:
+        case CMD_UNITY_BATCH_EXECUTE:
         case CMD_UNITY_TERMINATE:
         case CMD_UNITY_REMOUNT:
         case CMD_UNITY_REBOOT:
@@ -486,11 +512,29 @@ bool HdcServerForClient::DoCommandRemote(HChannel hChannel, void *formatCommandI
         case CMD_APP_INIT:
         case CMD_APP_UNINSTALL:
         case CMD_UNITY_BUGREPORT_INIT:
-        case CMD_APP_SIDELOAD: {
+        case CMD_APP_SIDELOAD:
+        case CMD_BENCH_INIT: {
             TaskCommand(hChannel, formatCommandInput);
             ret = true;
             break;
         }
+        case CMD_KERNEL_STAT: {
+            HdcServer *ptrServer = (HdcServer *)clsServer;
+            HSession hSession = FindAliveSession(hChannel->targetSessionId);
+            if (!hSession) {
+                break;
+            }
+            // tasks belong to the session work thread, only its counters are read from here
+            string echo = "server:\n" + ptrServer->DumpSessionStat(hSession, false) +
+                          DumpChannelStat(hChannel->targetSessionId) +
+                          HdcLatency::Dump(formatCommand->parameters == "r");
+            EchoClientRaw(hChannel, (uint8_t *)echo.c_str(), echo.size());
+            // the daemon echoes its side and closes the channel
+            ret = SendToDaemon(hChannel, CMD_UNITY_STAT,
+                               reinterpret_cast<uint8_t *>(const_cast<char *>(formatCommand->parameters.c_str())),
+                               sizeSend);
+            break;
+        }
         default:
             break;
     }
@@ -564,7 +608,7 @@ int HdcServerForClient::BindChannelToSession(HChannel hChannel, uint8_t *bufPtr,
             return;
         }
         auto ctrl = HdcSessionBase::BuildCtrlString(SP_ATTACH_CHANNEL, hChannel->channelId, nullptr, 0);
-        Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrl.data(), ctrl.size());
+        ((HdcServer *)thisClass->clsServer)->SendCtrlToWorkThread(hSession, ctrl);
     });
     return RET_SUCCESS;
 }
@@ -627,6 +671,7 @@ int HdcServerForClient::ReadChannel(HChannel hChannel, uint8_t *bufPtr, const in
         return ChannelHandShake(hChannel, bufPtr, bytesIO);
     }
     struct TranslateCommand::FormatCommand formatCommand = { 0 };
+    hChannel->commandBeginNs = uv_hrtime();
     if (!hChannel->interactiveShellMode) {
         string retEcho = String2FormatCommand((char *)bufPtr, bytesIO, &formatCommand);
         if (retEcho.length()) {
@@ -672,6 +717,7 @@ bool HdcServerForClient::ChannelSendSessionCtrlMsg(vector<uint8_t> &ctrlMsg, uin
     if (!hSession) {
         return false;
     }
-    return Base::SendToStream((uv_stream_t *)&hSession->ctrlPipe[STREAM_MAIN], ctrlMsg.data(), ctrlMsg.size()) > 0;
+    HdcServer *ptrServer = (HdcServer *)clsServer;
+    return ptrServer->SendCtrlToWorkThread(hSession, ctrlMsg) > 0;
 }
 }  // namespace Hdc
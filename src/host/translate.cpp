@@ -70,6 +70,7 @@ namespace TranslateCommand {
               "                                         node config name format 'schema:content'\n"
               "                                         examples are below:\n"
               "                                         tcp:<port>\n"
+              "                                         udp:<port> (to udp only, datagrams kept)\n"
               "                                         localfilesystem:<unix domain socket name>\n"
               "                                         localreserved:<unix domain socket name>\n"
               "                                         localabstract:<unix domain socket name>\n"
@@ -91,10 +92,20 @@ namespace TranslateCommand {
               "debug commands:\n"
               " hilog [-v]                            - Show device log, -v for detail\n"
               " shell [COMMAND...]                    - Run shell command (interactive shell if no command given)\n"
+              " batch [-j N] COMMAND...               - Run shell commands concurrently, N at a time (default 8)\n"
+              "                                         output is tagged records, '<id> out|err <size>\\n' and\n"
+              "                                         data, then '<id> exit <code>\\n', id is the command index\n"
               " bugreport [PATH]                      - Return all information from the device, path will be save "
               "localpath\n"
               " jpid                                  - List pids of processes hosting a JDWP transport\n"
               " sideload [PATH]                       - Sideload the given full OTA package\n"
+              " bench [MODE] [option]                 - Measure the link to device, MODE is ping|push|pull|duplex\n"
+              "                                         -s: packet size in bytes\n"
+              "                                         -c: packets in flight\n"
+              "                                         -n: packet count, -t: seconds, default 5s\n"
+              " stat [-r]                             - Dump traffic counters and latency of server, with -t also "
+              "of device\n"
+              "                                         -r: reset latency histograms after dump\n"
               "\n"
               "security commands:\n"
               " keygen FILE                           - Generate public/private key; key stored in FILE and FILE.pub\n";
@@ -147,8 +158,9 @@ namespace TranslateCommand {
         } else {
             const char *p = input + 6;
             // clang-format off
-            if (strncmp(p, "tcp:", 4) && strncmp(p, "localabstract:", 14) && strncmp(p, "localreserved:", 14) &&
-                strncmp(p, "localfilesystem:", 16) && strncmp(p, "dev:", 4) && strncmp(p, "jdwp:", 5)) {
+            if (strncmp(p, "tcp:", 4) && strncmp(p, "udp:", 4) && strncmp(p, "localabstract:", 14) &&
+                strncmp(p, "localreserved:", 14) && strncmp(p, "localfilesystem:", 16) && strncmp(p, "dev:", 4) &&
+                strncmp(p, "jdwp:", 5)) {
                 stringError = "Incorrect forward command";
                 outCmd->bJumpDo = true;
             }
@@ -281,6 +293,21 @@ namespace TranslateCommand {
             if (outCmd->parameters.size() == CMDSTR_BUGREPORT.size()) {
                 outCmd->parameters += " ";
             }
+        } else if (input == CMDSTR_BATCH
+                   || !strncmp(input.c_str(), string(CMDSTR_BATCH + " ").c_str(), CMDSTR_BATCH.size() + 1)) {
+            outCmd->cmdFlag = CMD_UNITY_BATCH_EXECUTE;
+            outCmd->parameters = input.c_str() + CMDSTR_BATCH.size();
+        } else if (!strncmp(input.c_str(), CMDSTR_BENCH.c_str(), CMDSTR_BENCH.size())) {
+            outCmd->cmdFlag = CMD_BENCH_INIT;
+            outCmd->parameters = input;
+            if (outCmd->parameters.size() == CMDSTR_BENCH.size()) {
+                outCmd->parameters += " ";
+            }
+        } else if (input == CMDSTR_STAT || input == CMDSTR_STAT + " -r") {
+            outCmd->cmdFlag = CMD_KERNEL_STAT;
+            if (input.size() > CMDSTR_STAT.size()) {
+                outCmd->parameters = "r";
+            }
         }
         // Inner command, protocol uses only
         else if (!strncmp(input.c_str(), CMDSTR_INNER_ENABLE_KEEPALIVE.c_str(), CMDSTR_INNER_ENABLE_KEEPALIVE.size())) {
@@ -68,6 +68,14 @@ TEST(AppCommand, HandleNoneZeroInput)
     GTEST_ASSERT_EQ(true, ftest->CheckEntry(ftest->UT_MOD_APP));
     delete ftest;
 }
+
+TEST(HdcLoopbackPerf, HandleNoneZeroInput)
+{
+    Runtime *ftest = new Runtime();
+    GTEST_ASSERT_EQ(true, ftest->Initial(true, true));
+    GTEST_ASSERT_EQ(true, ftest->CheckEntry(ftest->UT_MOD_PERF));
+    delete ftest;
+}
 }  // namespace HdcTest
 
 int main(int argc, const char *argv[])
@@ -41,6 +41,8 @@ enum UtType {
 const string DEBUG_ADDRESS = Hdc::DEFAULT_SERVER_ADDR;
 const string DEBUG_TCP_CONNECT_KEY = "127.0.0.1:10178";
 const string DEBUG_USB_CONNECT_KEY = "any";
+const string DEBUG_LOOPBACK_NAME = "ut";
+const string DEBUG_LOOPBACK_CONNECT_KEY = Hdc::LOOPBACK_KEY_PREFIX + DEBUG_LOOPBACK_NAME;
 
 int TestRuntimeCommand(const int method, const string &debugServerPort, const string &debugConnectKey);
 int TestRuntimeCommandSimple(bool bTCPorUSB, int method, bool bNeedConnectDaemon);
@@ -30,6 +30,7 @@ using Hdc::HdcServer;
 
 #include "ut_command.h"
 #include "ut_mod.h"
+#include "ut_perf.h"
 #include "ut_runtime.h"
 
 #endif  // end HDC_UT_COMMON_H
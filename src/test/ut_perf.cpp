@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ut_perf.h"
+#include <arpa/inet.h>
+#include <cmath>
+#include <netinet/in.h>
+#include <random>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+using namespace Hdc;
+
+namespace HdcTest {
+static double ElapsedMs(const uint64_t begin)
+{
+    return static_cast<double>(uv_hrtime() - begin) / BENCH_NS_PER_MS;
+}
+
+static bool FileSizeIs(const string &path, const uint64_t size)
+{
+    struct stat statbuf;
+    return stat(path.c_str(), &statbuf) == 0 && static_cast<uint64_t>(statbuf.st_size) == size;
+}
+
+// one line per case, so results of several runs can be diffed or loaded by a regression checker
+static void WritePerfResult(const PerfResult &result)
+{
+    constexpr double bytesPerMB = 1024.0 * 1024.0;
+    constexpr double msPerSecond = 1000.0;
+    double mbps = 0;
+    if (result.elapsedMs > 0) {
+        mbps = static_cast<double>(result.bytes) * result.rounds / bytesPerMB / (result.elapsedMs / msPerSecond);
+    }
+    vector<double> latency = result.latencyMs;
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&latency](const double rank) -> double {
+        if (latency.empty()) {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(std::ceil(rank * latency.size()));
+        return latency[std::min(std::max(index, static_cast<size_t>(1)), latency.size()) - 1];
+    };
+    constexpr double p50 = 0.5;
+    constexpr double p99 = 0.99;
+    string line = Base::StringFormat("{\"case\":\"%s\",\"transport\":\"loopback\",\"passed\":%s,\"rounds\":%u,"
+                                     "\"bytes\":%" PRIu64 ",\"elapsed_ms\":%.3f,\"mbps\":%.2f,"
+                                     "\"latency_ms\":{\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f}}\n",
+                                     result.name.c_str(), result.passed ? "true" : "false", result.rounds,
+                                     result.bytes, result.elapsedMs, mbps, percentile(p50), percentile(p99),
+                                     latency.empty() ? 0 : latency.back());
+    Base::WriteBinFile(PERF_RESULT_FILE.c_str(), (uint8_t *)line.c_str(), line.size(), false);
+    WRITE_LOG(LOG_INFO, "Perf result %s", line.c_str());
+}
+
+static void PerfClientRounds(Runtime *rt, PerfResult &result, const string &cmd, const string &output)
+{
+    result.passed = true;
+    for (uint32_t i = 0; i < result.rounds; ++i) {
+        if (!output.empty()) {
+            unlink(output.c_str());
+        }
+        uint64_t begin = uv_hrtime();
+        TestRunClient(DEBUG_ADDRESS, rt->GetConnectKey(), cmd);
+        double ms = ElapsedMs(begin);
+        result.latencyMs.push_back(ms);
+        result.elapsedMs += ms;
+        if (!output.empty() && !FileSizeIs(output, result.bytes)) {
+            WRITE_LOG(LOG_WARN, "Perf %s round %u output size mismatch", result.name.c_str(), i);
+            result.passed = false;
+        }
+    }
+}
+
+static bool PerfFileTransfer(Runtime *rt)
+{
+    string localFile = UT_TMP_PATH + "/perf.local";
+    string remoteFile = UT_TMP_PATH + "/perf.remote";
+    string backFile = UT_TMP_PATH + "/perf.back";
+    // random content so that compression or sparse paths do not flatter the numbers
+    vector<uint8_t> buf(PERF_FILE_SIZE);
+    std::mt19937_64 gen(Base::GetRandom());
+    for (size_t i = 0; i + sizeof(uint64_t) <= buf.size(); i += sizeof(uint64_t)) {
+        uint64_t value = gen();
+        (void)memcpy_s(buf.data() + i, buf.size() - i, &value, sizeof(value));
+    }
+    if (Base::WriteBinFile(localFile.c_str(), buf.data(), buf.size(), true) < 0) {
+        return false;
+    }
+    PerfResult send = { "file_send", PERF_FILE_ROUNDS, PERF_FILE_SIZE, 0, {}, false };
+    PerfClientRounds(rt, send, Base::StringFormat("file send %s %s", localFile.c_str(), remoteFile.c_str()),
+                     remoteFile);
+    WritePerfResult(send);
+    PerfResult recv = { "file_recv", PERF_FILE_ROUNDS, PERF_FILE_SIZE, 0, {}, false };
+    PerfClientRounds(rt, recv, Base::StringFormat("file recv %s %s", remoteFile.c_str(), backFile.c_str()),
+                     backFile);
+    WritePerfResult(recv);
+    return send.passed && recv.passed;
+}
+
+static bool PerfShell(Runtime *rt)
+{
+    PerfResult shell = { "shell_echo", PERF_SHELL_ROUNDS, 0, 0, {}, false };
+    PerfClientRounds(rt, shell, "shell echo hdc", "");
+    WritePerfResult(shell);
+    return shell.passed;
+}
+
+static int PerfSocket(const uint16_t port, bool listenOrConnect)
+{
+    constexpr int timeoutSecond = 10;
+    constexpr int backlog = 5;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct timeval timeout = { timeoutSecond, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int ret = listenOrConnect ? bind(fd, (struct sockaddr *)&addr, sizeof(addr)) :
+                                connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret < 0 || (listenOrConnect && listen(fd, backlog) < 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// source -> host listen port -> session -> daemon -> target port -> sink
+static bool PerfForward(Runtime *rt)
+{
+    PerfResult forward = { "forward_tcp", 1, PERF_FORWARD_SIZE, 0, {}, false };
+    int listenFd = PerfSocket(PERF_FORWARD_TARGET_PORT, true);
+    if (listenFd < 0) {
+        return false;
+    }
+    uint64_t sinkBytes = 0;
+    std::thread sink([listenFd, &sinkBytes]() {
+        int fd = accept(listenFd, nullptr, nullptr);  // times out by SO_RCVTIMEO
+        if (fd < 0) {
+            return;
+        }
+        vector<char> buf(MAX_SIZE_IOBUF);
+        ssize_t n = 0;
+        while ((n = read(fd, buf.data(), buf.size())) > 0) {
+            sinkBytes += n;
+        }
+        close(fd);
+    });
+    string task = Base::StringFormat("tcp:%u tcp:%u", PERF_FORWARD_LISTEN_PORT, PERF_FORWARD_TARGET_PORT);
+    TestRunClient(DEBUG_ADDRESS, rt->GetConnectKey(), "fport " + task);
+    uint64_t begin = uv_hrtime();
+    int fd = PerfSocket(PERF_FORWARD_LISTEN_PORT, false);
+    if (fd >= 0) {
+        vector<char> buf(MAX_SIZE_IOBUF, 'h');
+        uint64_t sent = 0;
+        while (sent < PERF_FORWARD_SIZE) {
+            ssize_t n = write(fd, buf.data(), std::min(buf.size(), static_cast<size_t>(PERF_FORWARD_SIZE - sent)));
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        shutdown(fd, SHUT_WR);
+    }
+    sink.join();
+    forward.elapsedMs = ElapsedMs(begin);
+    forward.latencyMs.push_back(forward.elapsedMs);
+    forward.passed = sinkBytes == PERF_FORWARD_SIZE;
+    if (fd >= 0) {
+        close(fd);
+    }
+    close(listenFd);
+    TestRunClient(DEBUG_ADDRESS, rt->GetConnectKey(), "fport rm " + task);
+    WritePerfResult(forward);
+    return forward.passed;
+}
+
+bool TestLoopbackPerf(void *runtimePtr)
+{
+    Runtime *rt = (Runtime *)runtimePtr;
+    unlink(PERF_RESULT_FILE.c_str());
+    bool ret = PerfShell(rt);
+    ret = PerfFileTransfer(rt) && ret;
+    ret = PerfForward(rt) && ret;
+    return ret;
+}
+}  // namespace HdcTest
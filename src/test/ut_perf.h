@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_UT_PERF_H
+#define HDC_UT_PERF_H
+#include "ut_common.h"
+
+namespace HdcTest {
+// Perf workloads over the loopback link, one JSON object per line is appended to PERF_RESULT_FILE
+const string PERF_RESULT_FILE = Hdc::UT_TMP_PATH + "/perf-loopback.json";
+constexpr uint32_t PERF_FILE_SIZE = 32 * 1024 * 1024;
+constexpr uint32_t PERF_FILE_ROUNDS = 3;
+constexpr uint32_t PERF_SHELL_ROUNDS = 50;
+constexpr uint32_t PERF_FORWARD_SIZE = 64 * 1024 * 1024;
+constexpr uint16_t PERF_FORWARD_LISTEN_PORT = 8091;
+constexpr uint16_t PERF_FORWARD_TARGET_PORT = 8092;
+
+struct PerfResult {
+    string name;
+    uint32_t rounds;
+    uint64_t bytes;    // per round
+    double elapsedMs;  // all rounds
+    vector<double> latencyMs;
+    bool passed;
+};
+
+bool TestLoopbackPerf(void *runtimePtr);
+}  // namespace HdcTest
+#endif  // HDC_UT_PERF_H
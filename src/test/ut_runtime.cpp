@@ -48,7 +48,7 @@ Runtime::~Runtime()
 
 int Runtime::InnerCall(int method)
 {
-    return TestRuntimeCommand(method, DEBUG_ADDRESS.c_str(), DEBUG_TCP_CONNECT_KEY.c_str());
+    return TestRuntimeCommand(method, DEBUG_ADDRESS.c_str(), connectKey.c_str());
 }
 
 void Runtime::CheckStopServer(uv_idle_t *arg)
@@ -97,7 +97,12 @@ void Runtime::StartDaemon(uv_work_t *arg)
 {
     Runtime *thisClass = static_cast<Runtime *>(arg->data);
     HdcDaemon daemon(false);
-    daemon.InitMod(true, false);
+    if (thisClass->bLoopback) {
+        daemon.InitMod(false, false);
+        daemon.InitLoopback(DEBUG_LOOPBACK_NAME);
+    } else {
+        daemon.InitMod(true, false);
+    }
     thisClass->daemon = &daemon;
 
     uv_idle_t *idt = &thisClass->checkDaemonStop;
@@ -119,7 +124,7 @@ int Runtime::CheckServerDaemonReady()
         return ERR_UT_MODULE_NOTREADY;
     }
     if (bConnectToDaemon) {
-        PreConnectDaemon(DEBUG_ADDRESS.c_str(), DEBUG_TCP_CONNECT_KEY.c_str());
+        PreConnectDaemon(DEBUG_ADDRESS.c_str(), connectKey.c_str());
     }
     hashInitialize = true;
     return RET_SUCCESS;
@@ -152,6 +157,9 @@ void Runtime::DoCheck(uv_timer_t *handle)
             case UT_MOD_APP:
                 thisClass->bCheckResult = TestAppCommand(thisClass);
                 break;
+            case UT_MOD_PERF:
+                thisClass->bCheckResult = TestLoopbackPerf(thisClass);
+                break;
             default:
                 break;
         }
@@ -160,9 +168,11 @@ void Runtime::DoCheck(uv_timer_t *handle)
     thisClass->checkFinish = true;
 }
 
-bool Runtime::Initial(bool bConnectToDaemonIn)
+bool Runtime::Initial(bool bConnectToDaemonIn, bool bLoopbackIn)
 {
     bConnectToDaemon = bConnectToDaemonIn;
+    bLoopback = bLoopbackIn;
+    connectKey = bLoopback ? DEBUG_LOOPBACK_CONNECT_KEY : DEBUG_TCP_CONNECT_KEY;
     constexpr int sleepTime = 300;
     auto funcServerFinish = [](uv_work_t *req, int status) -> void {
         auto thisClass = (Runtime *)req->data;
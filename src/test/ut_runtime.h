@@ -26,10 +26,11 @@ public:
         UT_MOD_FILE,
         UT_MOD_FORWARD,
         UT_MOD_APP,
+        UT_MOD_PERF,
     };
     Runtime();
     ~Runtime();
-    bool Initial(bool bConnectToDaemonIn);
+    bool Initial(bool bConnectToDaemonIn, bool bLoopbackIn = false);
     bool CheckEntry(UtModType type);
 
     bool ResetUtTmpFolder();
@@ -39,6 +40,10 @@ public:
     {
         return &loopMain;
     };
+    const string &GetConnectKey()
+    {
+        return connectKey;
+    };
 
 private:
     static void DoCheck(uv_timer_t *handle);
@@ -62,6 +67,8 @@ private:
     void *daemon;  // Hdc::HdcDaemon *
     uint8_t waitServerDaemonReadyCount = 0;
     bool bConnectToDaemon = false;
+    bool bLoopback = false;  // server and daemon joined in process, no TCP or USB needed
+    string connectKey = DEBUG_TCP_CONNECT_KEY;
 };
 }  // namespace HdcTest
 #endif  // HDC_FUNC_TEST_H
\ No newline at end of file
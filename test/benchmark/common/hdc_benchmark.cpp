@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Microbenchmarks of the protocol hot paths, built with -fno-access-control so protected members can be driven
+// directly. usage: hdc_benchmark [name filter]
+#include "hdc_benchmark.h"
+#ifndef HDC_HOST
+#include <sys/wait.h>
+#endif
+
+using namespace Hdc;
+
+namespace HdcBenchmark {
+constexpr uint32_t BENCH_SESSION_ID = 0x12345678;
+constexpr uint32_t BENCH_CHANNEL_ID = 0x1234;
+// keeps results alive so the compiler can not drop the measured work
+static volatile uint64_t g_sink = 0;
+
+void HdcBenchmarkRunner::Add(const string &name, const uint64_t bytesPerOp, BenchFunc func)
+{
+    if (!filter.empty() && name.find(filter) == string::npos) {
+        return;
+    }
+    cases.push_back({ name, bytesPerOp, func });
+}
+
+bool HdcBenchmarkRunner::Run(const BenchCase &benchCase)
+{
+    // warm up caches and lazily allocated buffers
+    if (!benchCase.func(1)) {
+        return false;
+    }
+    uint64_t iterations = 1;
+    uint64_t elapsed = 0;
+    while (true) {
+        uint64_t begin = uv_hrtime();
+        if (!benchCase.func(iterations)) {
+            return false;
+        }
+        elapsed = uv_hrtime() - begin;
+        if (elapsed >= BENCH_MIN_TIME_NS || iterations >= BENCH_MAX_ITERATIONS) {
+            break;
+        }
+        iterations *= 2;  // 2: double until the minimum time is reached
+    }
+    constexpr double nsPerSecond = 1000000000.0;
+    double nsPerOp = static_cast<double>(elapsed) / iterations;
+    double bytesPerSecond = nsPerOp > 0 ? benchCase.bytesPerOp * nsPerSecond / nsPerOp : 0;
+    printf("%-40s %14.1f ns/op %16.0f bytes/sec %12" PRIu64 " iterations\n", benchCase.name.c_str(), nsPerOp,
+           bytesPerSecond, iterations);
+    fflush(stdout);
+    return true;
+}
+
+int HdcBenchmarkRunner::RunAll()
+{
+    int failed = 0;
+    for (auto &benchCase : cases) {
+        if (!Run(benchCase)) {
+            printf("%-40s FAILED\n", benchCase.name.c_str());
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+static vector<uint8_t> BuildPayload(const int size)
+{
+    vector<uint8_t> payload(size);
+    for (int i = 0; i < size; ++i) {
+        payload[i] = static_cast<uint8_t>(i);
+    }
+    return payload;
+}
+
+static void AddChecksumCases(HdcBenchmarkRunner &runner)
+{
+    for (int size : BENCH_PAYLOAD_SIZES) {
+        runner.Add("Base::CalcCheckSum/" + std::to_string(size), size, [size](uint64_t iterations) -> bool {
+            vector<uint8_t> payload = BuildPayload(size);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                g_sink += Base::CalcCheckSum(payload.data(), size);
+            }
+            return true;
+        });
+    }
+}
+
+static void AddSerialCases(HdcBenchmarkRunner &runner)
+{
+    HdcSessionBase::PayloadProtect protect = { BENCH_CHANNEL_ID, CMD_FILE_DATA, 0, 0x09 };
+    string protectString = SerialStruct::SerializeToString(protect);
+    runner.Add("SerialStruct::Serialize/PayloadProtect", protectString.size(), [protect](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            g_sink += SerialStruct::SerializeToString(protect).size();
+        }
+        return true;
+    });
+    runner.Add("SerialStruct::Parse/PayloadProtect", protectString.size(), [protectString](uint64_t iterations) {
+        HdcSessionBase::PayloadProtect parsed = {};
+        for (uint64_t i = 0; i < iterations; ++i) {
+            if (!SerialStruct::ParseFromString(parsed, protectString)) {
+                return false;
+            }
+            g_sink += parsed.channelId;
+        }
+        return true;
+    });
+
+    HdcTransferBase::TransferPayload payload = { 0x100000, HdcTransferBase::COMPRESS_NONE, MAX_SIZE_IOBUF,
+                                                 MAX_SIZE_IOBUF };
+    string payloadString = SerialStruct::SerializeToString(payload);
+    runner.Add("SerialStruct::Serialize/TransferPayload", payloadString.size(), [payload](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            g_sink += SerialStruct::SerializeToString(payload).size();
+        }
+        return true;
+    });
+    runner.Add("SerialStruct::Parse/TransferPayload", payloadString.size(), [payloadString](uint64_t iterations) {
+        HdcTransferBase::TransferPayload parsed = {};
+        for (uint64_t i = 0; i < iterations; ++i) {
+            if (!SerialStruct::ParseFromString(parsed, payloadString)) {
+                return false;
+            }
+            g_sink += parsed.index;
+        }
+        return true;
+    });
+}
+
+// A session sending into an in-process loopback link whose peer never reads, the inbox plays the role of the wire
+class BenchSession {
+public:
+    explicit BenchSession(HdcSessionBase &baseIn) : base(baseIn), loopback(false, &baseIn)
+    {
+        hSession = new HdcSession();
+        hSession->connType = CONN_LOOPBACK;
+        hSession->sessionId = BENCH_SESSION_ID;
+        hSession->classInstance = &base;
+        hSession->classModule = &loopback;
+        hSession->hLoopback = new HdcLoopbackEnd();
+        hSession->hLoopback->link = std::make_shared<HdcLoopbackLink>();
+        hSession->hLoopback->side = STREAM_MAIN;
+        Base::ReallocBuf(&hSession->ioBuf, &hSession->bufSize, HDC_SOCKETPAIR_SIZE);
+        base.AdminSession(OP_ADD, hSession->sessionId, hSession);
+    }
+    ~BenchSession()
+    {
+        base.AdminSession(OP_REMOVE, hSession->sessionId, nullptr);
+        delete hSession->hLoopback;
+        delete[] hSession->ioBuf;
+        delete hSession;
+    }
+    string &Wire()
+    {
+        return hSession->hLoopback->link->inbox[STREAM_WORK];
+    }
+    // one encoded packet as SendToSession puts it on the wire
+    string BuildPacket(const vector<uint8_t> &payload)
+    {
+        Wire().clear();
+        base.SendToSession(hSession, BENCH_CHANNEL_ID, CMD_FILE_DATA, payload.data(), payload.size());
+        string packet = Wire();
+        Wire().clear();
+        return packet;
+    }
+
+    HdcSessionBase &base;
+    HdcLoopback loopback;
+    HSession hSession;
+};
+
+static void AddSessionCases(HdcBenchmarkRunner &runner, HdcSessionBase &base)
+{
+    for (int size : BENCH_PAYLOAD_SIZES) {
+        string suffix = "/" + std::to_string(size);
+        runner.Add("HdcSessionBase::Send" + suffix, size, [&base, size](uint64_t iterations) {
+            BenchSession session(base);
+            vector<uint8_t> payload = BuildPayload(size);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (base.Send(BENCH_SESSION_ID, BENCH_CHANNEL_ID, CMD_FILE_DATA, payload.data(), size) <= 0) {
+                    return false;
+                }
+                session.Wire().clear();  // keeps capacity, like a drained socket buffer
+            }
+            return true;
+        });
+        runner.Add("HdcSessionBase::OnRead" + suffix, size, [&base, size](uint64_t iterations) {
+            BenchSession session(base);
+            string packet = session.BuildPacket(BuildPayload(size));
+            uint8_t *packetPtr = reinterpret_cast<uint8_t *>(packet.data());
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (base.OnRead(session.hSession, packetPtr, packet.size()) != static_cast<int>(packet.size())) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        runner.Add("HdcSessionBase::FetchIOBuf" + suffix, size * BENCH_PACKETS_PER_READ,
+                   [&base, size](uint64_t iterations) {
+            BenchSession session(base);
+            string packet = session.BuildPacket(BuildPayload(size));
+            string read;
+            for (uint32_t i = 0; i < BENCH_PACKETS_PER_READ; ++i) {
+                read += packet;
+            }
+            HSession hSession = session.hSession;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                // the read callback copies into ioBuf, so does the benchmark
+                if (memcpy_s(hSession->ioBuf, hSession->bufSize, read.data(), read.size()) != EOK
+                    || base.FetchIOBuf(hSession, hSession->ioBuf, read.size()) != static_cast<int>(read.size())) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+}
+
+class BenchUSB : public HdcUSBBase {
+public:
+    explicit BenchUSB(HdcSessionBase &base) : HdcUSBBase(false, &base) {}
+
+protected:
+    int UsbToHdcProtocol(uv_stream_t *stream, uint8_t *appendData, int dataSize) override
+    {
+        g_sink += appendData[0];
+        return dataSize;
+    }
+};
+
+static void AddUSBCases(HdcBenchmarkRunner &runner, HdcSessionBase &base)
+{
+    for (int size : BENCH_PAYLOAD_SIZES) {
+        runner.Add("HdcUSBBase::SendToHdcStream/" + std::to_string(size), size, [&base, size](uint64_t iterations) {
+            BenchUSB usb(base);
+            HdcSession session;
+            HdcUSB hUSB;
+            session.sessionId = BENCH_SESSION_ID;
+            session.hUSB = &hUSB;
+            vector<uint8_t> payload = BuildPayload(size);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                // the header is byte swapped in place when checked, rebuild it like a fresh bulk read
+                vector<uint8_t> header = usb.BuildPacketHeader(BENCH_SESSION_ID, USB_OPTION_HEADER, size);
+                if (usb.SendToHdcStream(&session, nullptr, header.data(), header.size()) != size
+                    || usb.SendToHdcStream(&session, nullptr, payload.data(), size) != 0) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+}
+
+#ifdef HDC_SUPPORT_UART
+class BenchUART : public HdcUARTBase {
+public:
+    explicit BenchUART(HdcSessionBase &base) : HdcUARTBase(base) {}
+    vector<uint8_t> lastPackage;
+
+protected:
+    void OnTransferError(const HSession session) override {}
+    HSession GetSession(const uint32_t sessionId, bool create) override
+    {
+        return nullptr;
+    }
+    void RequestSendPackage(uint8_t *data, const size_t length, bool queue) override
+    {
+        lastPackage.assign(data, data + length);
+    }
+    void ResponseUartTrans(uint32_t sessionId, uint32_t packageIndex, UartProtocolOption option) override {}
+    RetErrCode DispatchToWorkThread(HSession hSession, uint8_t *readBuf, int readBytes) override
+    {
+        g_sink += readBytes;
+        return RET_SUCCESS;
+    }
+};
+
+static void AddUARTCases(HdcBenchmarkRunner &runner, HdcSessionBase &base)
+{
+    // one UART package carries at most MAX_UART_SIZE_IOBUF with its head
+    const int uartPayloadSizes[] = { BENCH_PAYLOAD_SIZES[0], MAX_UART_SIZE_IOBUF - sizeof(UartHead) };
+    for (int size : uartPayloadSizes) {
+        string suffix = "/" + std::to_string(size);
+        runner.Add("HdcUARTBase::ValidateUartPacket" + suffix, size, [&base, size](uint64_t iterations) {
+            BenchUART uart(base);
+            HdcSession session;
+            HdcUART hUART;
+            session.sessionId = BENCH_SESSION_ID;
+            session.hUART = &hUART;
+            vector<uint8_t> payload = BuildPayload(size);
+            uart.SendUARTData(&session, payload.data(), size);
+            vector<uint8_t> package = uart.lastPackage;
+            uint32_t sessionId = 0;
+            uint32_t packageIndex = 0;
+            size_t packageSize = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (uart.ValidateUartPacket(package, sessionId, packageIndex, packageSize) != RET_SUCCESS) {
+                    return false;
+                }
+            }
+            return packageSize == package.size();
+        });
+        runner.Add("HdcUARTBase::PackageProcess" + suffix, size * BENCH_PACKETS_PER_READ,
+                   [&base, size](uint64_t iterations) {
+            BenchUART uart(base);
+            HdcSession session;
+            HdcUART hUART;
+            session.sessionId = BENCH_SESSION_ID;
+            session.hUART = &hUART;
+            vector<uint8_t> payload = BuildPayload(size);
+            vector<uint8_t> read;
+            for (uint32_t i = 0; i < BENCH_PACKETS_PER_READ; ++i) {
+                uart.SendUARTData(&session, payload.data(), size);
+                read.insert(read.end(), uart.lastPackage.begin(), uart.lastPackage.end());
+            }
+            vector<uint8_t> data;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                data = read;  // consumed packages are erased from the front
+                hUART.dispatchedPackageIndex = 0;
+                if (uart.PackageProcess(data, &session) != 0 || !data.empty()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+}
+#endif
+
+class BenchChannel : public HdcChannelBase {
+public:
+    explicit BenchChannel(uv_loop_t *loop) : HdcChannelBase(false, "", loop) {}
+
+protected:
+    int ReadChannel(HChannel hChannel, uint8_t *bufPtr, const int bytesIO) override
+    {
+        g_sink += bufPtr[0];
+        return bytesIO;
+    }
+};
+
+static void AddChannelCases(HdcBenchmarkRunner &runner, BenchChannel &channel)
+{
+    for (int size : BENCH_PAYLOAD_SIZES) {
+        runner.Add("HdcChannelBase::ReadStream/" + std::to_string(size), size * BENCH_PACKETS_PER_READ,
+                   [&channel, size](uint64_t iterations) {
+            vector<uint8_t> read;
+            vector<uint8_t> payload = BuildPayload(size);
+            uint32_t sizeBe = htonl(size);
+            for (uint32_t i = 0; i < BENCH_PACKETS_PER_READ; ++i) {
+                uint8_t *sizePtr = reinterpret_cast<uint8_t *>(&sizeBe);
+                read.insert(read.end(), sizePtr, sizePtr + DWORD_SERIALIZE_SIZE);
+                read.insert(read.end(), payload.begin(), payload.end());
+            }
+            HdcChannel hChannel = {};
+            hChannel.clsChannel = &channel;
+            hChannel.bufSize = read.size();
+            hChannel.ioBuf = read.data();
+            uv_tcp_t tcp = {};
+            tcp.data = &hChannel;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                // frames are parsed in place and fully consumed, ioBuf keeps its content
+                hChannel.availTailIndex = 0;
+                HdcChannelBase::ReadStream(reinterpret_cast<uv_stream_t *>(&tcp), read.size(), nullptr);
+                if (hChannel.availTailIndex != 0) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+}
+
+// One forwarded socket read packed into a session packet, compares the former MTU sized read with the full read
+// buffer. The loopback inbox is drained every round like a fast link.
+static void AddForwardCases(HdcBenchmarkRunner &runner, HdcSessionBase &base)
+{
+    const int readSizes[] = { BENCH_FORWARD_MTU_READ, static_cast<int>(FORWARD_READ_BUF_SIZE) };
+    for (int size : readSizes) {
+        runner.Add("HdcForwardBase::ReadForwardBuf/" + std::to_string(size), size, [&base, size](uint64_t iterations) {
+            BenchSession session(base);
+            TaskInformation taskInfo = {};
+            taskInfo.sessionId = BENCH_SESSION_ID;
+            taskInfo.channelId = BENCH_CHANNEL_ID;
+            taskInfo.ownerSession = session.hSession;
+            taskInfo.ownerSessionClass = &base;
+            taskInfo.runLoop = &base.loopMain;
+            HdcForwardBase forward(&taskInfo);
+            auto ctx = (HdcForwardBase::HCtxForward)forward.MallocContext(true);
+            ctx->type = HdcForwardBase::FORWARD_TCP;
+            uv_stream_t *stream = reinterpret_cast<uv_stream_t *>(&ctx->tcp);
+            uv_buf_t buf = {};
+            for (uint64_t i = 0; i < iterations; ++i) {
+                HdcForwardBase::AllocForwardBuf(reinterpret_cast<uv_handle_t *>(stream), size, &buf);
+                HdcForwardBase::ReadForwardBuf(stream, size, &buf);
+                session.Wire().clear();
+            }
+            bool ret = taskInfo.packetsOut == iterations;
+            forward.AdminContext(OP_REMOVE, ctx->id, nullptr);
+            delete ctx;
+            return ret;
+        });
+    }
+}
+
+#ifndef HDC_HOST
+// One-shot "echo" from Launch to the exit of the shell, started directly and on a warm worker of the pool
+static bool RunShellOnce(HdcShellPool &pool)
+{
+    HdcShellPool::Worker worker;
+    if (!pool.Launch(false, "echo hdc_pool", worker)) {
+        return false;
+    }
+    string output;
+    char buf[BUF_SIZE_DEFAULT];
+    while (true) {
+        ssize_t rc = read(worker.fdIO, buf, sizeof(buf));
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            break;
+        }
+        output.append(buf, rc);
+    }
+    close(worker.fdIO);
+    waitpid(worker.pid, nullptr, 0);
+    return output.find("hdc_pool") != string::npos;
+}
+
+static void AddShellPoolCases(HdcBenchmarkRunner &runner)
+{
+    runner.Add("HdcShellPool::Launch/direct", 0, [](uint64_t iterations) {
+        HdcShellPool pool;  // never started, every launch starts a shell directly
+        for (uint64_t i = 0; i < iterations; ++i) {
+            if (!RunShellOnce(pool)) {
+                return false;
+            }
+        }
+        return true;
+    });
+    runner.Add("HdcShellPool::Launch/warm", 0, [](uint64_t iterations) {
+        constexpr uint64_t refillWaitNs = 1000 * 1000 * 1000;
+        HdcShellPool pool;
+        pool.Start(1);
+        bool ret = true;
+        for (uint64_t i = 0; i < iterations && ret; ++i) {
+            // the refill thread forks the next worker while the previous shell runs, a lag counts against the pool
+            uint64_t begin = uv_hrtime();
+            while (pool.IdleCount(false) == 0 && uv_hrtime() - begin < refillWaitNs) {
+                std::this_thread::yield();
+            }
+            ret = pool.IdleCount(false) > 0 && RunShellOnce(pool);
+        }
+        pool.Stop();
+        return ret;
+    });
+}
+#endif
+}  // namespace HdcBenchmark
+
+int main(int argc, const char *argv[])
+{
+    Base::SetLogLevel(LOG_FATAL);
+    HdcSessionBase base(false);
+    int failed = 0;
+    {
+        HdcBenchmark::BenchChannel channel(&base.loopMain);
+        HdcBenchmark::HdcBenchmarkRunner runner(argc > 1 ? argv[1] : "");
+        HdcBenchmark::AddChecksumCases(runner);
+        HdcBenchmark::AddSerialCases(runner);
+        HdcBenchmark::AddSessionCases(runner, base);
+        HdcBenchmark::AddUSBCases(runner, base);
+#ifdef HDC_SUPPORT_UART
+        HdcBenchmark::AddUARTCases(runner, base);
+#endif
+        HdcBenchmark::AddChannelCases(runner, channel);
+        HdcBenchmark::AddForwardCases(runner, base);
+#ifndef HDC_HOST
+        HdcBenchmark::AddShellPoolCases(runner);
+#endif
+        failed = runner.RunAll();
+    }
+    // let the async handle of the channel finish closing
+    uv_run(&base.loopMain, UV_RUN_NOWAIT);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_BENCHMARK_H
+#define HDC_BENCHMARK_H
+#include "common.h"
+#include "forward.h"
+#include "serial_struct.h"
+
+namespace HdcBenchmark {
+using std::string;
+
+// each case runs at least this long after warm up, the iteration count doubles until then
+constexpr uint64_t BENCH_MIN_TIME_NS = 200 * 1000 * 1000;
+constexpr uint64_t BENCH_MAX_ITERATIONS = 1ULL << 30;
+constexpr uint32_t BENCH_PACKETS_PER_READ = 4;  // frames carried by one simulated socket read
+constexpr int BENCH_PAYLOAD_SIZES[] = { 64, 4096, Hdc::MAX_SIZE_IOBUF };
+constexpr int BENCH_FORWARD_MTU_READ = 1492 - 256 - 1;  // the former fixed forward read, one MTU less hdc header
+
+// runs the operation `iterations` times, returns false if the path under test reported an error
+using BenchFunc = std::function<bool(uint64_t iterations)>;
+
+struct BenchCase {
+    string name;
+    uint64_t bytesPerOp;
+    BenchFunc func;
+};
+
+class HdcBenchmarkRunner {
+public:
+    explicit HdcBenchmarkRunner(const string &filterIn) : filter(filterIn) {}
+    void Add(const string &name, const uint64_t bytesPerOp, BenchFunc func);
+    int RunAll();
+
+private:
+    bool Run(const BenchCase &benchCase);
+
+    string filter;
+    std::vector<BenchCase> cases;
+};
+}  // namespace HdcBenchmark
+#endif  // HDC_BENCHMARK_H
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "daemon_batch_test.h"
+
+using namespace testing::ext;
+namespace Hdc {
+void HdcDaemonBatchTest::SetUpTestCase() {}
+
+void HdcDaemonBatchTest::TearDownTestCase() {}
+
+void HdcDaemonBatchTest::SetUp()
+{
+    session.sessionId = 1;
+    session.mapTask = new map<uint32_t, HTaskInfo>();
+    session.isDead = true;  // nothing to send on, replies are dropped
+}
+
+void HdcDaemonBatchTest::TearDown()
+{
+    for (auto &item : *session.mapTask) {
+        delete (HdcDaemonBatch *)item.second->taskClass;
+        delete item.second;
+    }
+    session.mapTask->clear();
+    if (loopReady) {
+        uv_run(&session.childLoop, UV_RUN_NOWAIT);
+        uv_loop_close(&session.childLoop);
+        loopReady = false;
+    }
+    delete session.hLoopback;
+    session.hLoopback = nullptr;
+}
+
+HTaskInfo HdcDaemonBatchTest::Dispatch(const string &parameters)
+{
+    daemon.DispatchTaskData(&session, channelId, CMD_UNITY_BATCH_EXECUTE, (uint8_t *)parameters.c_str(),
+                            parameters.size());
+    return daemon.AdminTask(OP_QUERY, &session, channelId, nullptr);
+}
+
+vector<std::pair<uint16_t, string>> HdcDaemonBatchTest::RunLive(const string &parameters)
+{
+    constexpr uint64_t runTimeoutMs = 10000;
+    session.isDead = false;
+    session.connType = CONN_LOOPBACK;
+    session.classInstance = &daemon;
+    session.classModule = &loopback;
+    session.hLoopback = new HdcLoopbackEnd();
+    session.hLoopback->link = std::make_shared<HdcLoopbackLink>();
+    session.hLoopback->side = STREAM_WORK;
+    uv_loop_init(&session.childLoop);
+    loopReady = true;
+    // a hung command fails the test instead of the run
+    uv_timer_t timer;
+    uv_timer_init(&session.childLoop, &timer);
+    uv_timer_start(&timer, [](uv_timer_t *handle) { uv_stop(handle->loop); }, runTimeoutMs, 0);
+    uv_unref((uv_handle_t *)&timer);
+    Dispatch(parameters);
+    uv_run(&session.childLoop, UV_RUN_DEFAULT);
+    uv_close((uv_handle_t *)&timer, nullptr);
+    uv_run(&session.childLoop, UV_RUN_NOWAIT);
+    session.isDead = true;
+
+    using PayloadHead = HdcSessionBase::PayloadHead;
+    using PayloadProtect = HdcSessionBase::PayloadProtect;
+    vector<std::pair<uint16_t, string>> packets;
+    const string &wire = session.hLoopback->link->inbox[STREAM_MAIN];
+    size_t offset = 0;
+    while (offset + sizeof(PayloadHead) <= wire.size()) {
+        const PayloadHead *head = reinterpret_cast<const PayloadHead *>(wire.data() + offset);
+        size_t headSize = ntohs(head->headSize);
+        size_t dataSize = ntohl(head->dataSize);
+        offset += sizeof(PayloadHead);
+        PayloadProtect protect = {};
+        SerialStruct::ParseFromString(protect, wire.substr(offset, headSize));
+        packets.push_back({ protect.commandFlag, wire.substr(offset + headSize, dataSize) });
+        offset += headSize + dataSize;
+    }
+    return packets;
+}
+
+/*
+ * @tc.name: TestDispatchCreatesTask
+ * @tc.desc: a batch request gets its own task on the daemon, like the other single side unity commands
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcDaemonBatchTest, TestDispatchCreatesTask, TestSize.Level0)
+{
+    bool masterTask = true;
+    EXPECT_TRUE(daemon.NeedNewTaskInfo(CMD_UNITY_BATCH_EXECUTE, masterTask));
+    EXPECT_FALSE(masterTask);
+
+    HTaskInfo hTaskInfo = Dispatch("-j 0 true");
+    ASSERT_NE(hTaskInfo, nullptr);
+    EXPECT_EQ(hTaskInfo->taskType, TASK_BATCH);
+    ASSERT_NE(hTaskInfo->taskClass, nullptr);
+    // parallelism out of range, nothing is started
+    EXPECT_TRUE(((HdcDaemonBatch *)hTaskInfo->taskClass)->vecCommands.empty());
+}
+
+/*
+ * @tc.name: TestParseCommands
+ * @tc.desc: a bare -j is rejected instead of being run as the first command
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcDaemonBatchTest, TestParseCommands, TestSize.Level0)
+{
+    HTaskInfo hTaskInfo = Dispatch("-j");
+    ASSERT_NE(hTaskInfo, nullptr);
+    ASSERT_NE(hTaskInfo->taskClass, nullptr);
+    HdcDaemonBatch *batch = (HdcDaemonBatch *)hTaskInfo->taskClass;
+    EXPECT_TRUE(batch->vecCommands.empty());
+
+    EXPECT_FALSE(batch->ParseCommands("-j 4"));
+    EXPECT_TRUE(batch->vecCommands.empty());
+    EXPECT_TRUE(batch->ParseCommands("-j 4 \"echo a\" \"echo b\""));
+    EXPECT_EQ(batch->parallel, 4u);
+    ASSERT_EQ(batch->vecCommands.size(), 2u);
+    EXPECT_EQ(batch->vecCommands[0], "echo a");
+}
+
+/*
+ * @tc.name: TestRecords
+ * @tc.desc: output goes out as "<id> out|err <size>" records with the bytes behind them, then "<id> exit <code>",
+ *           and the channel is closed after the last command
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcDaemonBatchTest, TestRecords, TestSize.Level1)
+{
+    auto packets = RunLive("\"echo a; echo e >&2; exit 3\"");
+    ASSERT_FALSE(packets.empty());
+    EXPECT_EQ(packets.back().first, CMD_KERNEL_CHANNEL_CLOSE);
+    vector<string> records;
+    for (auto &packet : packets) {
+        if (packet.first == CMD_KERNEL_ECHO_RAW) {
+            records.push_back(packet.second);
+        }
+    }
+    // stdout and stderr are separate pipes, their records may come in either order
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_NE(std::find(records.begin(), records.end(), "0 out 2\na\n"), records.end());
+    EXPECT_NE(std::find(records.begin(), records.end(), "0 err 2\ne\n"), records.end());
+    EXPECT_EQ(records.back(), "0 exit 3\n");
+}
+
+/*
+ * @tc.name: TestParallelLimit
+ * @tc.desc: with -j 1 the second command starts only after the first has exited, however long the first runs
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcDaemonBatchTest, TestParallelLimit, TestSize.Level1)
+{
+    auto packets = RunLive("-j 1 \"sleep 0.2; echo a\" \"echo b\"");
+    vector<string> records;
+    for (auto &packet : packets) {
+        if (packet.first == CMD_KERNEL_ECHO_RAW) {
+            records.push_back(packet.second);
+        }
+    }
+    vector<string> expect = { "0 out 2\na\n", "0 exit 0\n", "1 out 2\nb\n", "1 exit 0\n" };
+    EXPECT_EQ(records, expect);
+}
+} // namespace Hdc
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "forward_udp_test.h"
+
+using namespace testing::ext;
+namespace Hdc {
+void HdcForwardUdpTest::SetUpTestCase() {}
+
+void HdcForwardUdpTest::TearDownTestCase() {}
+
+void HdcForwardUdpTest::SetUp()
+{
+    uv_loop_init(&loop);
+    taskInfo.sessionId = 1;
+    taskInfo.channelId = 1;
+    taskInfo.runLoop = &loop;
+    taskInfo.ownerSessionClass = &daemon;
+    taskInfo.ownerSession = nullptr;
+    forward = new HdcForwardBase(&taskInfo);
+    forward->StartUdpHandles();
+}
+
+void HdcForwardUdpTest::TearDown()
+{
+    for (auto ctx : contexts) {
+        if (ctx->udpServer == nullptr) {
+            Base::TryCloseHandle((uv_handle_t *)&ctx->udp);
+        }
+    }
+    forward->StopUdpHandles();
+    uv_run(&loop, UV_RUN_DEFAULT);
+    for (auto ctx : contexts) {
+        forward->AdminContext(OP_REMOVE, ctx->id, nullptr);
+        delete ctx;
+    }
+    contexts.clear();
+    delete forward;
+    forward = nullptr;
+    uv_loop_close(&loop);
+}
+
+HdcForwardBase::HCtxForward HdcForwardUdpTest::MallocUdpSocket(bool masterSlave)
+{
+    auto ctx = (HdcForwardBase::HCtxForward)forward->MallocContext(masterSlave);
+    ctx->type = HdcForwardBase::FORWARD_UDP;
+    ctx->udpServer = nullptr;
+    ctx->ready = true;
+    ctx->udp.data = ctx;
+    uv_udp_init(&loop, &ctx->udp);
+    struct sockaddr_in addr;
+    uv_ip4_addr("127.0.0.1", 0, &addr);
+    EXPECT_EQ(uv_udp_bind(&ctx->udp, (const struct sockaddr *)&addr, 0), 0);
+    EXPECT_EQ(uv_udp_recv_start(&ctx->udp, HdcForwardBase::AllocForwardBuf, HdcForwardBase::ReadForwardUdp), 0);
+    contexts.push_back(ctx);
+    return ctx;
+}
+
+HdcForwardBase::HCtxForward HdcForwardUdpTest::MallocUdpPeer(HdcForwardBase::HCtxForward ctxListen)
+{
+    auto ctx = (HdcForwardBase::HCtxForward)forward->MallocContext(true);
+    ctx->type = HdcForwardBase::FORWARD_UDP;
+    ctx->udpServer = ctxListen;
+    ctx->ready = true;
+    contexts.push_back(ctx);
+    return ctx;
+}
+
+static size_t CountPending(const vector<uint32_t> &pending, uint32_t id)
+{
+    return std::count(pending.begin(), pending.end(), id);
+}
+
+/*
+ * @tc.name: TestPausedPeerKeepsListener
+ * @tc.desc: pausing one peer of the master listener holds only its datagrams, the other peers keep flowing
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcForwardUdpTest, TestPausedPeerKeepsListener, TestSize.Level0)
+{
+    auto ctxListen = MallocUdpSocket(true);
+    auto peerPaused = MallocUdpPeer(ctxListen);
+    auto peerOther = MallocUdpPeer(ctxListen);
+    peerPaused->remotePaused = true;  // as CMD_FORWARD_PAUSE for this peer
+    forward->StopSourceRead(peerPaused);
+    EXPECT_TRUE(uv_is_active((uv_handle_t *)&ctxListen->udp));
+
+    uint8_t datagram[16] = { 0 };
+    forward->AppendUdpDatagram(peerPaused, datagram, sizeof(datagram));
+    forward->AppendUdpDatagram(peerOther, datagram, sizeof(datagram));
+    EXPECT_EQ(peerPaused->udpBatch.size(), sizeof(uint16_t) + sizeof(datagram));
+    EXPECT_EQ(CountPending(forward->vecUdpPending, peerPaused->id), 0u);
+    EXPECT_EQ(CountPending(forward->vecUdpPending, peerOther->id), 1u);
+    EXPECT_FALSE(forward->FlushUdpBatch(peerPaused));
+
+    peerPaused->remotePaused = false;
+    forward->StartSourceRead(peerPaused);
+    EXPECT_EQ(CountPending(forward->vecUdpPending, peerPaused->id), 1u);
+}
+
+/*
+ * @tc.name: TestPausedPeerHoldsOneBatch
+ * @tc.desc: a paused peer keeps at most one batch of datagrams, the rest is dropped like udp would
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcForwardUdpTest, TestPausedPeerHoldsOneBatch, TestSize.Level0)
+{
+    auto ctxListen = MallocUdpSocket(true);
+    auto peer = MallocUdpPeer(ctxListen);
+    peer->readPaused = true;
+    forward->StopSourceRead(peer);
+
+    const size_t datagramSize = 1024;
+    vector<uint8_t> datagram(datagramSize);
+    for (size_t i = 0; i < FORWARD_READ_BUF_SIZE / datagramSize * 2; ++i) {  // 2: twice what one batch holds
+        forward->AppendUdpDatagram(peer, datagram.data(), datagram.size());
+    }
+    EXPECT_GT(peer->udpBatch.size(), 0u);
+    EXPECT_LE(peer->udpBatch.size(), static_cast<size_t>(FORWARD_READ_BUF_SIZE));
+    EXPECT_EQ(CountPending(forward->vecUdpPending, peer->id), 0u);
+    EXPECT_TRUE(uv_is_active((uv_handle_t *)&ctxListen->udp));
+}
+
+/*
+ * @tc.name: TestSlaveSocketPause
+ * @tc.desc: a slave side context owns its socket, pausing it stops and resumes that socket only
+ *           and a batch held over the pause is queued again on resume
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcForwardUdpTest, TestSlaveSocketPause, TestSize.Level0)
+{
+    auto ctxSlave = MallocUdpSocket(false);
+    auto ctxOther = MallocUdpSocket(false);
+    uint8_t datagram[16] = { 0 };
+    forward->AppendUdpDatagram(ctxSlave, datagram, sizeof(datagram));
+    EXPECT_EQ(CountPending(forward->vecUdpPending, ctxSlave->id), 1u);
+
+    // CMD_FORWARD_PAUSE lands before the check phase, which then drops the id
+    ctxSlave->remotePaused = true;
+    forward->StopSourceRead(ctxSlave);
+    HdcForwardBase::FlushUdpCallback(&forward->udpFlush);
+    EXPECT_EQ(CountPending(forward->vecUdpPending, ctxSlave->id), 0u);
+    EXPECT_EQ(ctxSlave->udpBatch.size(), sizeof(uint16_t) + sizeof(datagram));
+    EXPECT_FALSE(uv_is_active((uv_handle_t *)&ctxSlave->udp));
+    EXPECT_TRUE(uv_is_active((uv_handle_t *)&ctxOther->udp));
+
+    ctxSlave->remotePaused = false;
+    forward->StartSourceRead(ctxSlave);
+    EXPECT_TRUE(uv_is_active((uv_handle_t *)&ctxSlave->udp));
+    EXPECT_EQ(CountPending(forward->vecUdpPending, ctxSlave->id), 1u);
+}
+} // namespace Hdc
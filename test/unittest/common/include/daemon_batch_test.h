@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_DAEMON_BATCH_TEST_H
+#define HDC_DAEMON_BATCH_TEST_H
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "daemon_common.h"
+namespace Hdc {
+class HdcDaemonBatchTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+    // pushes one batch request through DispatchTaskData, returns the task it created or nullptr
+    HTaskInfo Dispatch(const string &parameters);
+    // runs a batch on a loopback session until it is done, returns the command and payload of every packet it sent
+    vector<std::pair<uint16_t, string>> RunLive(const string &parameters);
+
+    HdcDaemon daemon { false };
+    HdcLoopback loopback { false, &daemon };
+    HdcSession session;
+    uint32_t channelId = 1;
+    bool loopReady = false;
+};
+} // namespace Hdc
+#endif // HDC_DAEMON_BATCH_TEST_H
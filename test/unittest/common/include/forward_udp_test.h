@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_FORWARD_UDP_TEST_H
+#define HDC_FORWARD_UDP_TEST_H
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "daemon_common.h"
+namespace Hdc {
+class HdcForwardUdpTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+    // a udp context with its own socket bound to a loopback port and reading
+    HdcForwardBase::HCtxForward MallocUdpSocket(bool masterSlave);
+    // a peer of the master listener, answered through the socket of ctxListen
+    HdcForwardBase::HCtxForward MallocUdpPeer(HdcForwardBase::HCtxForward ctxListen);
+
+    HdcDaemon daemon { false };
+    uv_loop_t loop;
+    TaskInformation taskInfo = {};
+    HdcForwardBase *forward = nullptr;
+    vector<HdcForwardBase::HCtxForward> contexts;
+};
+} // namespace Hdc
+#endif // HDC_FORWARD_UDP_TEST_H
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HDC_SHELL_POOL_TEST_H
+#define HDC_SHELL_POOL_TEST_H
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "shell_pool.h"
+namespace Hdc {
+class HdcShellPoolTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+    // output until EOF, firstByteNs gets the time the first byte arrived
+    static string ReadOutput(int fd, uint64_t &firstByteNs);
+    static bool WaitIdle(HdcShellPool &pool, bool pty, size_t count);
+};
+} // namespace Hdc
+#endif // HDC_SHELL_POOL_TEST_H
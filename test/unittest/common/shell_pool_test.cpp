@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "shell_pool_test.h"
+#include <sys/wait.h>
+#include <thread>
+
+using namespace testing::ext;
+namespace Hdc {
+void HdcShellPoolTest::SetUpTestCase()
+{
+    signal(SIGPIPE, SIG_IGN);
+}
+
+void HdcShellPoolTest::TearDownTestCase() {}
+
+void HdcShellPoolTest::SetUp() {}
+
+void HdcShellPoolTest::TearDown() {}
+
+string HdcShellPoolTest::ReadOutput(int fd, uint64_t &firstByteNs)
+{
+    string output;
+    char buf[BUF_SIZE_DEFAULT];
+    firstByteNs = 0;
+    while (true) {
+        ssize_t rc = read(fd, buf, sizeof(buf));
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {  // EIO ends a PTY
+            break;
+        }
+        if (firstByteNs == 0) {
+            firstByteNs = uv_hrtime();
+        }
+        output.append(buf, rc);
+    }
+    return output;
+}
+
+bool HdcShellPoolTest::WaitIdle(HdcShellPool &pool, bool pty, size_t count)
+{
+    constexpr int waitRounds = 200;
+    for (int i = 0; i < waitRounds; ++i) {
+        if (pool.IdleCount(pty) >= count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+/*
+ * @tc.name: TestParallelLaunch
+ * @tc.desc: Launch from several threads at once, each gets its own output.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcShellPoolTest, TestParallelLaunch, TestSize.Level1)
+{
+    constexpr int threadCount = 8;
+    HdcShellPool pool;
+    pool.Start(2);
+    WaitIdle(pool, false, 2);
+    std::atomic<int> okCount(0);
+    vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&pool, &okCount, i]() {
+            HdcShellPool::Worker worker;
+            string expect = "hdc_parallel_" + std::to_string(i);
+            if (!pool.Launch(false, "echo " + expect, worker)) {
+                return;
+            }
+            uint64_t firstByteNs = 0;
+            string output = ReadOutput(worker.fdIO, firstByteNs);
+            close(worker.fdIO);
+            waitpid(worker.pid, nullptr, 0);
+            if (output == expect + "\n") {
+                ++okCount;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    pool.Stop();
+    EXPECT_EQ(okCount.load(), threadCount);
+}
+
+/*
+ * @tc.name: TestLaunchSplit
+ * @tc.desc: stdout, stderr and the exit code of a command come back on their own pipes, even after exit.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcShellPoolTest, TestLaunchSplit, TestSize.Level1)
+{
+    HdcShellPool::Worker worker;
+    ASSERT_TRUE(HdcShellPool::LaunchSplit("echo hdc_out; echo hdc_err >&2; exit 3", worker));
+    uint64_t firstByteNs = 0;
+    EXPECT_EQ(ReadOutput(worker.fdIO, firstByteNs), "hdc_out\n");
+    EXPECT_EQ(ReadOutput(worker.fdErr, firstByteNs), "hdc_err\n");
+    EXPECT_EQ(ReadOutput(worker.fdStatus, firstByteNs), "3\n");
+    close(worker.fdIO);
+    close(worker.fdErr);
+    close(worker.fdStatus);
+    waitpid(worker.pid, nullptr, 0);
+}
+
+/*
+ * @tc.name: TestInteractivePty
+ * @tc.desc: An empty command on a PTY worker starts an interactive shell reading the PTY.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcShellPoolTest, TestInteractivePty, TestSize.Level1)
+{
+    HdcShellPool pool;
+    pool.Start(1);
+    ASSERT_TRUE(WaitIdle(pool, true, 1)) << "Pool not refilled";
+    HdcShellPool::Worker worker;
+    ASSERT_TRUE(pool.Launch(true, "", worker));
+    const string input = "echo hdc_$((6*7))\nexit\n";
+    ASSERT_EQ(write(worker.fdIO, input.c_str(), input.size()), static_cast<ssize_t>(input.size()));
+    uint64_t firstByteNs = 0;
+    string output = ReadOutput(worker.fdIO, firstByteNs);
+    close(worker.fdIO);
+    waitpid(worker.pid, nullptr, 0);
+    pool.Stop();
+    EXPECT_NE(output.find("hdc_42"), string::npos) << output;
+}
+}  // namespace Hdc
@@ -837,4 +837,23 @@ HWTEST_F(HdcUARTBaseTest, ResponseUartTrans, TestSize.Level1)
     EXPECT_CALL(mockUARTBase, RequestSendPackage(_, sizeof(UartHead), false));
     mockUARTBase.ResponseUartTrans(sessionId, packageIndex, PKG_OPTION_FREE);
 }
+
+/*
+ * @tc.name: CountRetransmit
+ * @tc.desc: Check the retransmit counter of the session is increased once the session is found
+ * @tc.type: FUNC
+ */
+HWTEST_F(HdcUARTBaseTest, CountRetransmit, TestSize.Level1)
+{
+    const uint32_t sessionId = 12345;
+    HdcSession session;
+    session.sessionId = sessionId;
+    EXPECT_CALL(mockUARTBase, GetSession(sessionId, false)).WillOnce(Return(&session));
+    mockUARTBase.CountRetransmit(sessionId);
+    EXPECT_EQ(session.stat.retransmits, 1u);
+
+    EXPECT_CALL(mockUARTBase, GetSession(sessionId, false)).WillOnce(Return(nullptr));
+    mockUARTBase.CountRetransmit(sessionId);
+    EXPECT_EQ(session.stat.retransmits, 1u);
+}
 } // namespace Hdc